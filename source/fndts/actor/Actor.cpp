@@ -0,0 +1,150 @@
+// Foundations library (actor): Actor class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own
+// program.
+
+/**
+ *  \file   Actor.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Actor class implementation file.
+**/
+
+#include "Actor.h"
+#include "ActorSystem.h"
+
+using namespace fndts::actor;
+using fndts::comms::Message;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: getMailboxSize
+// Returns the number of pending messages
+const size_t Actor::getMailboxSize()
+{
+    mutex.lock();
+    size_t n = mailbox.size();
+    mutex.unlock();
+    return n;
+}
+
+// Public method: close
+// Drops the pending messages. While a worker runs the actor the mailbox is
+// left to it, as the message being handled is still in there.
+const bool Actor::close()
+{
+    mutex.lock();
+    closed = true;
+    if (!scheduled) mailbox.clear();
+    mutex.unlock();
+    return true;
+}
+
+// Public method: send
+// Appends a copy of the message and schedules the actor if it was idle
+const bool Actor::send(const Message & m)
+{
+    mutex.lock();
+    if (closed)
+    {
+        mutex.unlock();
+        return false;
+    }
+    mailbox.push_back(m);
+    traceEnqueue(mailbox.back());
+    bool idle = !scheduled;
+    scheduled = true;
+    mutex.unlock();
+
+    if (idle) system.schedule(this);
+    return true;
+}
+
+// Public method: receive
+// Not supported
+const bool Actor::receive(Message & r)
+{
+    return false;
+}
+
+// Protected method: unhandled
+// Ignores the message
+void Actor::unhandled(const Message & m)
+{
+}
+
+// Private method: run
+// Handles the messages at the front of the mailbox. They are handled in
+// place, without the mutex: senders only append and the actor is run by a
+// single worker at a time. The actor stays scheduled while messages remain,
+// so that senders do not queue it twice.
+const bool Actor::run(const unsigned int n)
+{
+    unsigned int done = 0;
+    unsigned long dropped = 0;
+    mutex.lock();
+    while (!closed && done < n && !mailbox.empty())
+    {
+        Message & m = mailbox.front();
+        mutex.unlock();
+
+        if (m.isExpired()) dropped++;
+        else
+        {
+            traceDequeue(m);
+            std::map<long,tHandler>::const_iterator h =
+                handlers.find(m.getType());
+            if (h != handlers.end()) (this->*(h->second))(m);
+            else unhandled(m);
+            done++;
+        }
+
+        mutex.lock();
+        mailbox.pop_front();
+    }
+    if (closed) mailbox.clear();
+    bool more = !mailbox.empty();
+    scheduled = more;
+    mutex.unlock();
+
+    handled += done;
+    if (dropped > 0) countExpired(dropped);
+    __sync_fetch_and_add(&system.processed, done);
+    return more;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Actor
+// Creates an idle actor with an empty mailbox
+Actor::Actor(ActorSystem & s, const std::string & n)
+:
+    /* Attribute construction */
+    system(s),
+    mailbox(),
+    handlers(),
+    scheduled(false),
+    closed(false),
+    handled(0),
+    mutex(),
+
+    /* Superclass construction */
+    Channel(n)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Actor
+// Drops the pending messages
+Actor::~Actor()
+{
+    close();
+}
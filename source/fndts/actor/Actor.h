@@ -0,0 +1,158 @@
+// Foundations library (fndts): Actor class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Actor.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Actor class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "comms/Channel.h"
+#include "comms/Message.h"
+#include "os/thread/MutexThread.h"
+#include <deque>
+#include <map>
+#include <string>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace actor {
+    class Actor;
+    class ActorSystem;
+} }
+
+/**
+ *  \ingroup actor
+ *  \brief   An object with a mailbox whose messages are handled by the
+ *           workers of an ActorSystem.
+ *
+ *  An actor is a Channel: sending to it appends the message to its mailbox
+ *  and, if the actor was idle, puts it in the run queue of its system. A
+ *  worker thread then handles the messages of the mailbox one after another,
+ *  up to the throughput of the system, before moving to the next actor. The
+ *  messages of one actor are never handled by two workers at the same time,
+ *  so handlers need no locking of the actor state.
+ *
+ *  Messages are dispatched by type (see comms::Message::getType()) to the
+ *  handlers registered with handle(), usually from the constructor of the
+ *  subclass:
+ *  \code
+ *  class Counter : public Actor
+ *  {
+ *      void onAdd(const comms::Message & m) { ... }
+ *    public:
+ *      Counter(ActorSystem & s):Actor(s, "counter")
+ *      { handle(ADD, &Counter::onAdd); }
+ *  };
+ *  \endcode
+ *  Messages without a handler are given to unhandled(). Expired messages
+ *  are dropped without being handled.
+ *
+ *  An actor must not be destroyed while its system may run it: stop the
+ *  system first. An actor cannot be used to receive: receive() always fails.
+**/
+class fndts::actor::Actor : public fndts::comms::Channel
+{
+    friend class ActorSystem;
+
+    public:
+        /** \brief  A message handler of a subclass. **/
+        typedef void (Actor::*tHandler)(const comms::Message & m);
+
+    private:
+        ActorSystem & system;       /* The system running the actor */
+        std::deque<comms::Message> mailbox;  /* Pending messages */
+        std::map<long,tHandler> handlers;   /* Handler of each type */
+        bool scheduled;     /* Queued or running in the system */
+        bool closed;        /* No more messages accepted */
+        volatile unsigned long handled;     /* Messages handled */
+        fndts::os::MutexThread mutex;   /* Mutex for the mailbox */
+
+        /* Copy constructor and assignment operator disabled */
+        Actor(const Actor & src):Channel("disabled"),system(src.system) {}
+        Actor & operator = (const Actor & src) { return *this; }
+
+        /* Handles up to n messages. Tells whether more are pending. */
+        const bool run(const unsigned int n);
+
+    protected:
+        /**
+         *  \brief  Registers the handler of a message type.
+         *  \param  t   The message type.
+         *  \param  h   The handler, a method of the subclass.
+        **/
+        template <class A>
+        inline void handle(const long t,
+                           void (A::*h)(const comms::Message & m))
+        { handlers[t] = static_cast<tHandler>(h); }
+
+        /**
+         *  \brief  Handles a message of a type without handler. Does nothing
+         *          unless overridden.
+         *  \param  m   The message.
+        **/
+        virtual void unhandled(const comms::Message & m);
+
+    public:
+        /**
+         *  \brief  Creates an idle actor.
+         *  \param  s   The system that will run the actor.
+         *  \param  n   The name of the actor.
+        **/
+        Actor(ActorSystem & s, const std::string & n);
+
+        /**
+         *  \brief  Destroys the actor and its pending messages.
+        **/
+        virtual ~Actor();
+
+        /**
+         *  \brief  Gets the system running the actor.
+         *  \return The system.
+        **/
+        inline ActorSystem & getSystem() const
+        { return system; }
+
+        /**
+         *  \brief  Gets the number of messages handled.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getHandledCount() const
+        { return handled; }
+
+        /**
+         *  \brief  Gets the number of messages in the mailbox.
+         *  \return The number of messages.
+        **/
+        const size_t getMailboxSize();
+
+        /**
+         *  \brief  Drops the pending messages and refuses new ones. The
+         *          message being handled, if any, is completed.
+         *  \return true.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Appends a Message to the mailbox and schedules the
+         *          actor.
+         *  \param  m   Message to send.
+         *  \return true if accepted; false if the actor is closed.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Not supported: messages are given to the handlers.
+         *  \param  r   Unused.
+         *  \return false.
+        **/
+        virtual const bool receive (comms::Message & r);
+};
@@ -0,0 +1,146 @@
+// Foundations library (actor): ActorSystem class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own
+// program.
+
+/**
+ *  \file   ActorSystem.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ActorSystem class implementation file.
+**/
+
+#include <sstream>
+#include "ActorSystem.h"
+#include "Actor.h"
+#include "os/thread/Thread.h"
+
+using namespace fndts::actor;
+
+/* A worker thread of the system */
+class ActorSystem::Worker : public fndts::os::Thread
+{
+    private:
+        ActorSystem & system;
+
+    protected:
+        /* Runs actors until told to stop */
+        virtual void * threadStartRoutine(void *arg)
+        {
+            Actor *a;
+            while ((a = system.next()) != NULL)
+            {
+                __sync_fetch_and_add(&system.runs, 1);
+                if (a->run(system.throughput)) system.schedule(a);
+            }
+            return NULL;
+        }
+
+    public:
+        Worker(const std::string & n, ActorSystem & s):Thread(n),system(s) {}
+};
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: stop
+// Queues a NULL entry per worker and joins them. A worker getting a NULL
+// while actors remain queued puts it back, so the pending messages are
+// handled before the last worker leaves.
+void ActorSystem::stop()
+{
+    mutex.lock();
+    if (stopping)
+    {
+        mutex.unlock();
+        return;
+    }
+    stopping = true;
+    for (size_t i=0; i<workers.size(); i++) runqueue.push_back(NULL);
+    mutex.unlock();
+    ready.post(workers.size());
+
+    for (size_t i=0; i<workers.size(); i++)
+    {
+        workers[i]->join();
+        delete workers[i];
+    }
+    workers.clear();
+}
+
+// Private method: schedule
+// Appends the actor to the run queue
+void ActorSystem::schedule(Actor *a)
+{
+    mutex.lock();
+    runqueue.push_back(a);
+    queued++;
+    mutex.unlock();
+    ready.post(1);
+}
+
+// Private method: next
+// Takes the first entry of the run queue
+Actor * ActorSystem::next()
+{
+    while (true)
+    {
+        ready.wait();
+        mutex.lock();
+        Actor *a = runqueue.front();
+        runqueue.pop_front();
+        if (a != NULL) queued--;
+        else if (queued > 0)
+        {
+            runqueue.push_back(NULL);
+            mutex.unlock();
+            ready.post(1);
+            continue;
+        }
+        mutex.unlock();
+        return a;
+    }
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: ActorSystem
+// Creates the system and launches its workers
+ActorSystem::ActorSystem(const std::string & n, const unsigned int w,
+                         const unsigned int t)
+:
+    /* Attribute construction */
+    name(n),
+    workers(),
+    runqueue(),
+    queued(0),
+    throughput(t > 0 ? t : 1),
+    stopping(false),
+    processed(0),
+    runs(0),
+    ready(),
+    mutex()
+{
+    for (unsigned int i=0; i<(w > 0 ? w : 1); i++)
+    {
+        std::ostringstream s;
+        s << name << " worker " << i;
+        workers.push_back(new Worker(s.str(), *this));
+        workers.back()->launch(NULL);
+    }
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~ActorSystem
+// Stops the workers
+ActorSystem::~ActorSystem()
+{
+    stop();
+}
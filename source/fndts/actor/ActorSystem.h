@@ -0,0 +1,131 @@
+// Foundations library (fndts): ActorSystem class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ActorSystem.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ActorSystem class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/thread/FutexThread.h"
+#include "os/thread/MutexThread.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace actor {
+    class ActorSystem;
+    class Actor;
+} }
+
+/**
+ *  \ingroup actor
+ *  \brief   A pool of worker threads running the Actor objects with pending
+ *           messages.
+ *
+ *  Actors with messages wait in a run queue. A worker takes the first one,
+ *  handles up to a given number of its messages (the throughput) and, if
+ *  the actor still has messages, puts it back at the end of the queue.
+ *  Handling several messages of the same actor in a row keeps its state in
+ *  the cache, while the limit keeps a busy actor from starving the others.
+ *
+ *  Idle actors cost no thread and no wake up, so a few workers can run tens
+ *  of thousands of actors. The workers start with the system; stop() (or
+ *  the destructor) lets them handle the pending messages and joins them.
+**/
+class fndts::actor::ActorSystem
+{
+    friend class Actor;
+
+    private:
+        class Worker;
+
+        std::string name;           /* Name of the system */
+        std::vector<Worker*> workers;   /* The worker threads */
+        std::deque<Actor*> runqueue;    /* Actors with messages; NULL stops */
+        size_t queued;              /* Actors in the run queue */
+        unsigned int throughput;    /* Messages handled per run of an actor */
+        bool stopping;              /* stop() was called */
+        volatile unsigned long processed;   /* Messages handled */
+        volatile unsigned long runs;        /* Actors run */
+        fndts::os::FutexThread ready;   /* Entries in the run queue */
+        fndts::os::MutexThread mutex;   /* Mutex for the run queue */
+
+        /* Copy constructor and assignment operator disabled */
+        ActorSystem(const ActorSystem & src) {}
+        ActorSystem & operator = (const ActorSystem & src) { return *this; }
+
+        /* Appends an actor to the run queue */
+        void schedule(Actor *a);
+
+        /* Waits for the next actor to run; NULL when the worker must stop */
+        Actor * next();
+
+    public:
+        /**
+         *  \brief  Creates a system and starts its workers.
+         *  \param  n   The name of the system, prefix of the worker names.
+         *  \param  w   The number of worker threads (at least 1).
+         *  \param  t   The messages of an actor handled in a row.
+        **/
+        ActorSystem(const std::string & n, const unsigned int w = 1,
+                    const unsigned int t = 64);
+
+        /**
+         *  \brief  Stops the system.
+        **/
+        virtual ~ActorSystem();
+
+        /**
+         *  \brief  Lets the workers handle the pending messages, including
+         *          the ones sent meanwhile, and joins them. Messages sent
+         *          afterwards are not handled.
+        **/
+        void stop();
+
+        /**
+         *  \brief  Gets the name of the system.
+         *  \return The name.
+        **/
+        inline const std::string getName() const
+        { return name; }
+
+        /**
+         *  \brief  Gets the number of worker threads.
+         *  \return The number of workers.
+        **/
+        inline const unsigned int getWorkerCount() const
+        { return workers.size(); }
+
+        /**
+         *  \brief  Gets the messages of an actor handled in a row.
+         *  \return The throughput.
+        **/
+        inline const unsigned int getThroughput() const
+        { return throughput; }
+
+        /**
+         *  \brief  Gets the number of messages handled by all the actors.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getProcessedCount() const
+        { return processed; }
+
+        /**
+         *  \brief  Gets the number of times an actor was run. Compared with
+         *          the processed count, it tells how well messages batch.
+         *  \return The number of runs.
+        **/
+        inline const unsigned long getRunCount() const
+        { return runs; }
+};
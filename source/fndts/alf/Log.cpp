@@ -15,7 +15,7 @@
 **/
 
 #include <string>
-#include <string.h> /* for strlen */
+#include <string.h> /* for strlen and memcpy */
 #include "Log.h"
 #include "comms/Message.h"
 #include "os/thread/Thread.h"
@@ -30,36 +30,13 @@ using namespace fndts::alf;
 // Transforms this log into a message.
 fndts::comms::Message Log::toMessage() const
 {
-    /* 
-     *  The message is formed by:
-     *      - The log ending with the char 0
-     *      - The thread name ending with the char 0
-     *      - The channel name ending with the char 0
-     *      - The level of the log
-     *      - The type of log
-     */   
-    size_t sz = (strlen(this->text.c_str())+1) + 
-                (strlen(this->thread.c_str())+1) + 
-                (strlen(this->channel.c_str())+1) + 
-                sizeof(this->level) + 
-                sizeof(this->type);
-
     /* Allocate buffer for the needed data */
+    size_t sz = byteSize(this->channel,this->thread,this->text);
     fndts::comms::tByte buffer[sz];
 
-    /* Iterator through buffer */
-    fndts::comms::tByte *buffit = buffer;
-
     /* Set all data */
-    strcpy(reinterpret_cast<char *>(buffit),this->text.c_str()); 
-    buffit += strlen(this->text.c_str())+1;
-    strcpy(reinterpret_cast<char *>(buffit),this->thread.c_str()); 
-    buffit += strlen(this->thread.c_str())+1;
-    strcpy(reinterpret_cast<char *>(buffit),this->channel.c_str()); 
-    buffit += strlen(this->channel.c_str())+1;
-    *(reinterpret_cast<unsigned int *>(buffit)) = this->level; 
-    buffit += sizeof(this->level);
-    *(reinterpret_cast<eLogType *>(buffit)) = this->type;
+    toByteArray(buffer,this->type,this->level,this->channel,this->thread,
+                this->text);
 
     /* Create a message and copy there the data from the buffer */
     fndts::comms::Message msg;
@@ -71,6 +48,43 @@ fndts::comms::Message Log::toMessage() const
 
 /* -- Class methods --------------------------------------------------------- */
 
+// Public class method: byteSize
+// Returns the size of a serialized log
+const size_t Log::byteSize(const std::string & c, const std::string & th,
+                           const std::string & t)
+{
+    return (strlen(t.c_str())+1) +
+           (strlen(th.c_str())+1) +
+           (strlen(c.c_str())+1) +
+           sizeof(unsigned int) +
+           sizeof(eLogType);
+}
+
+// Public class method: toByteArray
+// Serializes a log. The bytes are formed by:
+//      - The log ending with the char 0
+//      - The thread name ending with the char 0
+//      - The channel name ending with the char 0
+//      - The level of the log
+//      - The type of log
+void Log::toByteArray(fndts::comms::tByte *b, const eLogType k,
+                      const unsigned int l, const std::string & c,
+                      const std::string & th, const std::string & t)
+{
+    size_t n = strlen(t.c_str())+1;
+    memcpy(b,t.c_str(),n);
+    b += n;
+    n = strlen(th.c_str())+1;
+    memcpy(b,th.c_str(),n);
+    b += n;
+    n = strlen(c.c_str())+1;
+    memcpy(b,c.c_str(),n);
+    b += n;
+    memcpy(b,&l,sizeof(l));
+    b += sizeof(l);
+    memcpy(b,&k,sizeof(k));
+}
+
 /* -- Constructors ---------------------------------------------------------- */
 
 // Public constructor: Log
@@ -101,6 +115,20 @@ Log::Log(const eLogType k, const unsigned int l, const std::string &c,
 {
 }
 
+// Public constructor: Log
+// Creates a new log object with the given level, channel, thread and text.
+Log::Log(const eLogType k, const unsigned int l, const std::string &c,
+         const std::string &th, const std::string &t)
+:
+    /* Attribute construction */
+    text(t),
+    channel(c),
+    thread(th),
+    level(l),
+    type(k)
+{
+}
+
 // Public constructor: Log
 // Creates a Log from a Message
 Log::Log(const fndts::comms::Message src)
@@ -108,20 +136,24 @@ Log::Log(const fndts::comms::Message src)
     /* Store locally the contents of the source message */
     fndts::comms::tByte buffer[src.size()];
     src.toByteArray(buffer);
+    *this = Log(buffer);
+}
 
-    /* Iterator through buffer */
-    fndts::comms::tByte *buffit = buffer;
-
-    /* Read data from the message and store it in this log */
-    this->text = reinterpret_cast<char *>(buffit);
-    buffit += strlen(this->text.c_str())+1;
-    this->thread = reinterpret_cast<char *>(buffit);
-    buffit += strlen(this->thread.c_str())+1;
-    this->channel = reinterpret_cast<char *>(buffit);
-    buffit += strlen(this->channel.c_str())+1;
-    this->level = *(reinterpret_cast<unsigned int *>(buffit));
+// Public constructor: Log
+// Creates a Log from the bytes written by toByteArray
+Log::Log(const fndts::comms::tByte *b)
+{
+    /* Read data from the bytes and store it in this log */
+    const char *buffit = reinterpret_cast<const char *>(b);
+    this->text = buffit;
+    buffit += this->text.size()+1;
+    this->thread = buffit;
+    buffit += this->thread.size()+1;
+    this->channel = buffit;
+    buffit += this->channel.size()+1;
+    memcpy(&this->level,buffit,sizeof(this->level));
     buffit += sizeof(this->level);
-    this->type = *(reinterpret_cast<eLogType *>(buffit));
+    memcpy(&this->type,buffit,sizeof(this->type));
 }
 
 /* -- Destructor ------------------------------------------------------------ */
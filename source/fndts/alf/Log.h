@@ -91,12 +91,29 @@ class fndts::alf::Log
             const std::string &t);
         /**@}**/
 
+        /**
+         *  \brief  Creates a new log entry issued by another thread.
+         *  \param  k   The kind(type) of log. See eLogType.
+         *  \param  l   The level of the log.
+         *  \param  c   Channel that originated the log.
+         *  \param  th  Name of the thread that issued the log.
+         *  \param  t   Text that will be output (the log itself).
+        **/
+        Log(const eLogType k, const unsigned int l, const std::string &c,
+            const std::string &th, const std::string &t);
+
         /**
          *  \brief  Creates a new %Log from a Message
          *  \param  src Message received through a Queue and containing a %Log.
         **/
         Log(const comms::Message src);
 
+        /**
+         *  \brief  Creates a new %Log from its serialized bytes.
+         *  \param  b   Bytes written by toByteArray().
+        **/
+        explicit Log(const comms::tByte *b);
+
         /**
          *  \brief  Deallocates a %Log.
         **/
@@ -143,4 +160,28 @@ class fndts::alf::Log
          *  \return The representing Message of this %Log.
         **/
         fndts::comms::Message toMessage() const;
+
+        /**
+         *  \brief  Gets the size of a serialized log.
+         *  \param  c   Channel that originated the log.
+         *  \param  th  Name of the thread issuing the log.
+         *  \param  t   Text of the log.
+         *  \return The number of bytes.
+        **/
+        static const size_t byteSize(const std::string & c,
+                                     const std::string & th,
+                                     const std::string & t);
+
+        /**
+         *  \brief  Serializes a log without building a %Log object.
+         *  \param  b   Where to write byteSize() bytes.
+         *  \param  k   The kind(type) of log. See eLogType.
+         *  \param  l   The level of the log.
+         *  \param  c   Channel that originated the log.
+         *  \param  th  Name of the thread issuing the log.
+         *  \param  t   Text of the log.
+        **/
+        static void toByteArray(comms::tByte *b, const eLogType k,
+                                const unsigned int l, const std::string & c,
+                                const std::string & th, const std::string & t);
 };
@@ -17,6 +17,7 @@
 #include "LogChannel.h"
 #include "Logger.h"
 #include "Log.h"
+#include "LogRing.h"
 #include "comms/Queue.h"
 #include "comms/Message.h"
 #include "os/thread/MutexThread.h"
@@ -39,84 +40,40 @@ const bool LogChannel::log(const std::string & log)
 // Outputs a log to the Logger object but only in case that the given level is 
 // equal or greater than the LogChannel's one and the Logger's global level.
 // In case the log was issued, it returns true; false, otherwise.
+// The level is checked without the mutex and the log is written to the ring
+// of the calling thread (see LogRing), so threads logging at the same time do
+// not wait for each other.
 const bool LogChannel::log(const unsigned int l, const std::string & log)
 {
-    bool sent=false;
-    this->mutex.lock();
-    if (this->level <= l)
-    { 
-        Log newlog(eSTANDARD,l,getName(),log);
-        Logger::getIOPort().send(newlog.toMessage());
-        sent=true; 
-    }
-    this->mutex.unlock();
-    return sent;
+    if (this->level > l) return false;
+    return LogRing::send(eSTANDARD,l,this->name,log);
 }
 
 // Public object method: error
 // Issues an error if the flag is set.
 const bool LogChannel::error(const std::string & e)
 {
-    bool sent=false;
-    this->mutex.lock();
-    if (this->eflag)
-    {
-        Log msg(eERROR,Logger::getGlobalLogLevel(),getName(),e);
-        Logger::getIOPort().send(msg.toMessage());
-        sent=true; 
-    }
-    this->mutex.unlock();
-    return sent;
+    if (!this->eflag) return false;
+    return LogRing::send(eERROR,Logger::getGlobalLogLevel(),this->name,e);
 }
 
 // Public object method: warning
 // Issues a warning if the flag is set.
 const bool LogChannel::warning(const std::string & w)
 {
-    bool sent=false;
-    this->mutex.lock();
-    if (this->eflag)
-    {
-        Log msg(eWARNING,Logger::getGlobalLogLevel(),getName(),w);
-        Logger::getIOPort().send(msg.toMessage());
-        sent=true; 
-    }
-    this->mutex.unlock();
-    return sent;
+    if (!this->eflag) return false;
+    return LogRing::send(eWARNING,Logger::getGlobalLogLevel(),this->name,w);
 }
 
-// Private method: doInsertInStreamOp
-// This is the actual implementation for the template operator <<. The operator
-// cannot be placed in this file because it is a template, and must have the
-// implementation available for their users. The operator, thus, will just call
-// this function after having updated the logstream attribute.
-void LogChannel::doInsertInStreamOp()
+// Public operator: <<
+// Starts a statement with a manipulator
+LogStream LogChannel::operator << (std::ostream & (*m)(std::ostream &))
 {
-    /* Get the string from the stream */
-    std::string logbuf = this->logstream.str();
-            
-    /* Search for all new lines */
-    int newlinepos = logbuf.find('\n');
-    while (newlinepos != std::string::npos)
-    {
-        /* Get the substring from beggining to new line and send it */
-        std::string newlog = logbuf.substr(0,newlinepos);
-        this->mutex.unlock();
-        log(getDefaultLogLevel(),newlog); 
-        this->mutex.lock();
-
-        /* Cut the already sent substring */
-        logbuf = logbuf.substr(newlinepos+1);
-
-        /* Next new line character */
-        newlinepos = logbuf.find('\n');
-    }
-
-    /* Update the stream and out */
-    this->logstream.str(logbuf);
+    LogStream s(*this);
+    s << m;
+    return s;
 }
 
-
 /* -- Constructors ---------------------------------------------------------- */
 
 // Private constructor: LogChannel
@@ -134,8 +91,7 @@ LogChannel::LogChannel(std::string n, const unsigned int l)
     name(n),
     wflag(true),
     eflag(true),
-    mutex(),
-    logstream()
+    mutex()
 {
 }
 
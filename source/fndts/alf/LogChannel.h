@@ -18,10 +18,12 @@
 
 /* Include files */
 #include "Logger.h"
+#include "LogFormat.h"
+#include "LogRing.h"
+#include "LogStream.h"
 #include "os/thread/MutexThread.h"
-#include <iostream>
+#include <ostream>
 #include <string>
-#include <sstream>
 
 /* Namespace definition and forward declarations */
 namespace fndts { namespace alf { class LogChannel; } }
@@ -67,8 +69,10 @@ namespace fndts { namespace alf { class LogChannel; } }
  *  flags in the %LogChannel object are active. Use the methods setErrorFlag() 
  *  and setWarningFlag() to modify these flags.
  *
- *  This class mutexes all accesses to its internals to guarantee correct 
- *  behavior when the same %LogChannel is used from different threads.
+ *  The same %LogChannel can be used from different threads. Issuing a log
+ *  takes no lock: the levels and flags are read as they are and each thread
+ *  writes its logs to its own LogRing. Only the setters take the mutex of
+ *  the channel.
  *
  *  Example:
  *  \code
@@ -81,11 +85,10 @@ class fndts::alf::LogChannel
 {
     private:
         static comms::Channel & channel; /* Channel to send/received logs */
-        unsigned int level;     /* Log level for the channel */
-        int deflev;             /* Default log level for logs issued */
+        volatile unsigned int level;    /* Log level for the channel */
+        volatile int deflev;    /* Default log level for logs issued */
         std::string name;       /* Name of the log channel */
-        bool wflag, eflag;      /* Warning and error flags */
-        std::stringstream logstream;    /* Stream for the << operator */
+        volatile bool wflag, eflag;     /* Warning and error flags */
         fndts::os::MutexThread mutex;   /* Mutex the access to attributes */
 
         /** 
@@ -110,13 +113,6 @@ class fndts::alf::LogChannel
         **/
         ~LogChannel();
 
-        /**
-         *  \brief  Actual implementation of the << operator. It is placed here
-         *          to hide it from the template operator implementation (which
-         *          must be placed in the header file).
-        **/
-        void doInsertInStreamOp ();
-
     public:
         /**
          *  \brief Requests this channel to issue a log.
@@ -168,6 +164,180 @@ class fndts::alf::LogChannel
         const bool warning(const std::string & w);
 
 
+        /**
+         *  \brief  Tells whether a log of the given level would be issued,
+         *          without taking any lock. Both the level of the channel and
+         *          the global level of the Logger are checked.
+         *  \param  l   Level of the log.
+         *  \return true if the log would be issued; false otherwise.
+        **/
+        inline const bool isEnabled(const unsigned int l) const
+        { return this->level <= l && Logger::getGlobalLogLevel() <= l; }
+
+        /**
+         *  \brief  Requests this channel to issue a binary log.
+         *
+         *  The text of the log is not built by the calling thread: only the
+         *  identifier of the format and the bytes of the arguments are
+         *  written, and the Logger thread builds the text (see LogFormat).
+         *  The arguments must be of a type supported by tLogArg: numbers,
+         *  characters, booleans, strings and pointers. There are versions
+         *  from no arguments up to six.
+         *
+         *  \param  l   Level of the requested log.
+         *  \param  f   Format of the log, a static object of the call site.
+         *  \param  a1  First argument, replacing the first {} of the format.
+         *
+         *  \return true when the log was issued; false otherwise.
+        **/
+        /**@{**/
+        inline const bool log(const unsigned int l, const LogFormat & f)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            LogRing::writeHeader(b,f,l,name);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1, class A2>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1,
+                              const A2 & a2)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1)
+                        + tLogArg<A2>::size(a2);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            b = tLogArg<A2>::write(b,a2);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1, class A2, class A3>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1,
+                              const A2 & a2,
+                              const A3 & a3)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1)
+                        + tLogArg<A2>::size(a2)
+                        + tLogArg<A3>::size(a3);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            b = tLogArg<A2>::write(b,a2);
+            b = tLogArg<A3>::write(b,a3);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1, class A2, class A3, class A4>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1,
+                              const A2 & a2,
+                              const A3 & a3,
+                              const A4 & a4)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1)
+                        + tLogArg<A2>::size(a2)
+                        + tLogArg<A3>::size(a3)
+                        + tLogArg<A4>::size(a4);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            b = tLogArg<A2>::write(b,a2);
+            b = tLogArg<A3>::write(b,a3);
+            b = tLogArg<A4>::write(b,a4);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1, class A2, class A3, class A4, class A5>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1,
+                              const A2 & a2,
+                              const A3 & a3,
+                              const A4 & a4,
+                              const A5 & a5)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1)
+                        + tLogArg<A2>::size(a2)
+                        + tLogArg<A3>::size(a3)
+                        + tLogArg<A4>::size(a4)
+                        + tLogArg<A5>::size(a5);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            b = tLogArg<A2>::write(b,a2);
+            b = tLogArg<A3>::write(b,a3);
+            b = tLogArg<A4>::write(b,a4);
+            b = tLogArg<A5>::write(b,a5);
+            LogRing::commit();
+            return true;
+        }
+
+        template <class A1, class A2, class A3, class A4, class A5, class A6>
+        inline const bool log(const unsigned int l, const LogFormat & f,
+                              const A1 & a1,
+                              const A2 & a2,
+                              const A3 & a3,
+                              const A4 & a4,
+                              const A5 & a5,
+                              const A6 & a6)
+        {
+            if (this->level > l) return false;
+            size_t sz = LogRing::headerSize(name)
+                        + tLogArg<A1>::size(a1)
+                        + tLogArg<A2>::size(a2)
+                        + tLogArg<A3>::size(a3)
+                        + tLogArg<A4>::size(a4)
+                        + tLogArg<A5>::size(a5)
+                        + tLogArg<A6>::size(a6);
+            comms::tByte *b = LogRing::reserve(sz);
+            if (b == NULL) return false;
+            b = LogRing::writeHeader(b,f,l,name);
+            b = tLogArg<A1>::write(b,a1);
+            b = tLogArg<A2>::write(b,a2);
+            b = tLogArg<A3>::write(b,a3);
+            b = tLogArg<A4>::write(b,a4);
+            b = tLogArg<A5>::write(b,a5);
+            b = tLogArg<A6>::write(b,a6);
+            LogRing::commit();
+            return true;
+        }
+        /**@}**/
+
         /** 
          *  \brief Returns the default log level that logs will have if no level
          *         is specified (i.e. using alf::operator&lt;&lt;).
@@ -237,28 +407,27 @@ class fndts::alf::LogChannel
         /**
          *  \brief  Operator &lt;&lt; to insert a log in the %LogChannel using
          *          the default log level.
-         *  \param  chan    The %LogChannel.
-         *  \param  l       The log
-         *  \return The %LogChannel with the new log inserted.
+         *  \param  l       The first value inserted.
+         *  \return A LogStream taking the rest of the statement.
          *
-         *  This operator builds a log and issues it only if it contains a new
-         *  line character. The characters beyond the last new line won't be 
-         *  issued, they will remain in the buffer until a new line is found in 
-         *  subsequent calls.
+         *  Each line is issued as soon as its new line character is inserted.
+         *  The text after the last new line is issued at the end of the
+         *  statement. See LogStream.
         **/
         template <typename Type>
-        LogChannel & operator << (Type l)
+        LogStream operator << (const Type & l)
         {
-            /* 
-             *  Why do I need to insert logstream.str()? It is supposed to be
-             *  already there!
-             */
-            this->mutex.lock();
-            this->logstream << this->logstream.str() << l;
-            this->doInsertInStreamOp();
-            this->mutex.unlock();
-            return *this;
+            LogStream s(*this);
+            s << l;
+            return s;
         }
+
+        /**
+         *  \brief  Operator &lt;&lt; starting a statement with a manipulator.
+         *  \param  m       The manipulator, such as std::endl.
+         *  \return A LogStream taking the rest of the statement.
+        **/
+        LogStream operator << (std::ostream & (*m)(std::ostream &));
         
         /* Friend declarations. */
         friend class Logger;
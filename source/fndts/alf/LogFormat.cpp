@@ -0,0 +1,159 @@
+// Foundations library (alf-another logging facility): LogFormat -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+
+/**
+ *  \file LogFormat.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %LogFormat class implementation file.
+**/
+
+#include "LogFormat.h"
+#include <sstream>
+
+using namespace fndts::alf;
+using fndts::comms::tByte;
+
+/* -- Static member initialization ------------------------------------------ */
+std::vector<const LogFormat*>   LogFormat::formats;
+fndts::os::MutexThread          LogFormat::mutex;
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: toText
+// Replaces each {} of the format with the next argument and appends the
+// arguments left. A truncated or unknown argument ends the text.
+const std::string LogFormat::toText(const tByte *b, const tByte *e) const
+{
+    std::ostringstream out;
+    size_t pos = 0;
+    while (true)
+    {
+        size_t next = format.find("{}",pos);
+        if (next == std::string::npos || b >= e)
+        {
+            out << format.substr(pos);
+            pos = format.size();
+            if (b >= e) break;
+            out << " ";
+        }
+        else
+        {
+            out << format.substr(pos,next-pos);
+            pos = next + 2;
+        }
+
+        tByte tag = *b++;
+        switch (tag)
+        {
+            case eARGINT:
+            {
+                int64_t v;
+                if (b + sizeof(v) > e) return out.str();
+                memcpy(&v,b,sizeof(v));
+                out << v;
+                b += sizeof(v);
+                break;
+            }
+            case eARGUINT:
+            {
+                uint64_t v;
+                if (b + sizeof(v) > e) return out.str();
+                memcpy(&v,b,sizeof(v));
+                out << v;
+                b += sizeof(v);
+                break;
+            }
+            case eARGDOUBLE:
+            {
+                double v;
+                if (b + sizeof(v) > e) return out.str();
+                memcpy(&v,b,sizeof(v));
+                out << v;
+                b += sizeof(v);
+                break;
+            }
+            case eARGCHAR:
+            {
+                if (b >= e) return out.str();
+                out << (char)*b++;
+                break;
+            }
+            case eARGBOOL:
+            {
+                if (b >= e) return out.str();
+                out << ((*b++ != 0) ? "true" : "false");
+                break;
+            }
+            case eARGSTRING:
+            {
+                uint32_t n;
+                if (b + sizeof(n) > e) return out.str();
+                memcpy(&n,b,sizeof(n));
+                b += sizeof(n);
+                if (b + n > e) return out.str();
+                out.write(reinterpret_cast<const char *>(b),n);
+                b += n;
+                break;
+            }
+            case eARGPOINTER:
+            {
+                void *v;
+                if (b + sizeof(v) > e) return out.str();
+                memcpy(&v,b,sizeof(v));
+                out << v;
+                b += sizeof(v);
+                break;
+            }
+            default:
+                return out.str();
+        }
+    }
+    return out.str();
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: find
+// Returns the format with the given identifier
+const LogFormat * LogFormat::find(const uint32_t i)
+{
+    const LogFormat *f = NULL;
+    mutex.lock();
+    if (i > 0 && i <= formats.size()) f = formats[i-1];
+    mutex.unlock();
+    return f;
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: LogFormat
+// Registers the format giving it the next identifier
+LogFormat::LogFormat(const char *f)
+:
+    /* Attribute construction */
+    format(f),
+    id(0)
+{
+    mutex.lock();
+    formats.push_back(this);
+    id = formats.size();
+    mutex.unlock();
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~LogFormat
+// Removes the format from the registry keeping its identifier taken
+LogFormat::~LogFormat()
+{
+    mutex.lock();
+    formats[id-1] = NULL;
+    mutex.unlock();
+}
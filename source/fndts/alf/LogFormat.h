@@ -0,0 +1,210 @@
+// Foundations library (alf-another logging facility): LogFormat class -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+/**
+ *  \file LogFormat.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The ALF LogFormat class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "comms/Message.h"
+#include "os/thread/MutexThread.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace alf {
+    class LogFormat;
+
+    /**
+     *  \brief  The type tags of the arguments of a binary log.
+    **/
+    enum eLogArg
+    {
+        eARGINT     = 1,    /**< Signed integer, stored as 64 bits **/
+        eARGUINT    = 2,    /**< Unsigned integer, stored as 64 bits **/
+        eARGDOUBLE  = 3,    /**< Floating point, stored as a double **/
+        eARGCHAR    = 4,    /**< A character **/
+        eARGBOOL    = 5,    /**< A boolean **/
+        eARGSTRING  = 6,    /**< 32 bits length followed by the characters **/
+        eARGPOINTER = 7     /**< An address **/
+    };
+
+    /**
+     *  \brief  Writes an argument of a binary log: a type tag followed by the
+     *          raw bytes. Only the specialized types can be logged.
+    **/
+    template <typename T> struct tLogArg;
+
+    /* Arguments copied as a value of type S */
+    #define ALF_LOG_ARG(T, TAG, S)                                             \
+    template <> struct tLogArg<T>                                              \
+    {                                                                          \
+        static inline const size_t size(const T & v)                           \
+        { return 1 + sizeof(S); }                                              \
+        static inline comms::tByte * write(comms::tByte *b, const T & v)       \
+        {                                                                      \
+            S s = (S)v;                                                        \
+            *b = TAG;                                                          \
+            memcpy(b+1,&s,sizeof(s));                                          \
+            return b+1+sizeof(s);                                              \
+        }                                                                      \
+    };
+
+    ALF_LOG_ARG(signed char, eARGINT, int64_t)
+    ALF_LOG_ARG(short, eARGINT, int64_t)
+    ALF_LOG_ARG(int, eARGINT, int64_t)
+    ALF_LOG_ARG(long, eARGINT, int64_t)
+    ALF_LOG_ARG(long long, eARGINT, int64_t)
+    ALF_LOG_ARG(unsigned char, eARGUINT, uint64_t)
+    ALF_LOG_ARG(unsigned short, eARGUINT, uint64_t)
+    ALF_LOG_ARG(unsigned int, eARGUINT, uint64_t)
+    ALF_LOG_ARG(unsigned long, eARGUINT, uint64_t)
+    ALF_LOG_ARG(unsigned long long, eARGUINT, uint64_t)
+    ALF_LOG_ARG(float, eARGDOUBLE, double)
+    ALF_LOG_ARG(double, eARGDOUBLE, double)
+    ALF_LOG_ARG(char, eARGCHAR, char)
+    ALF_LOG_ARG(bool, eARGBOOL, bool)
+
+    #undef ALF_LOG_ARG
+
+    /* Strings, copied as they may not outlive the log */
+    template <> struct tLogArg<const char *>
+    {
+        static inline const size_t size(const char * const & v)
+        { return 1 + sizeof(uint32_t) + strlen(v); }
+        static inline comms::tByte * write(comms::tByte *b,
+                                           const char * const & v)
+        {
+            uint32_t n = strlen(v);
+            *b++ = eARGSTRING;
+            memcpy(b,&n,sizeof(n));
+            memcpy(b+sizeof(n),v,n);
+            return b+sizeof(n)+n;
+        }
+    };
+    template <> struct tLogArg<char *> : public tLogArg<const char *> {};
+    template <size_t N> struct tLogArg<char[N]>
+    {
+        static inline const size_t size(const char (&v)[N])
+        { return tLogArg<const char *>::size(v); }
+        static inline comms::tByte * write(comms::tByte *b,
+                                           const char (&v)[N])
+        { return tLogArg<const char *>::write(b,v); }
+    };
+    template <> struct tLogArg<std::string>
+    {
+        static inline const size_t size(const std::string & v)
+        { return 1 + sizeof(uint32_t) + v.size(); }
+        static inline comms::tByte * write(comms::tByte *b,
+                                           const std::string & v)
+        {
+            uint32_t n = v.size();
+            *b++ = eARGSTRING;
+            memcpy(b,&n,sizeof(n));
+            memcpy(b+sizeof(n),v.data(),n);
+            return b+sizeof(n)+n;
+        }
+    };
+
+    /* Pointers, logged as addresses */
+    template <typename T> struct tLogArg<T *>
+    {
+        static inline const size_t size(T * const & v)
+        { return 1 + sizeof(v); }
+        static inline comms::tByte * write(comms::tByte *b, T * const & v)
+        {
+            *b = eARGPOINTER;
+            memcpy(b+1,&v,sizeof(v));
+            return b+1+sizeof(v);
+        }
+    };
+} }
+
+/**
+ *  \ingroup alf
+ *  \brief  The format of a binary log, registered once per call site.
+ *
+ *  A binary log does not format its text when issued. The calling thread
+ *  only writes the identifier of a %LogFormat and the raw bytes of the
+ *  arguments, each one preceded by a type tag (see tLogArg); the Logger
+ *  thread builds the text later. Each <tt>{}</tt> in the format is replaced
+ *  by the next argument; the arguments left are appended separated by
+ *  spaces.
+ *
+ *  A %LogFormat is meant to be a static object of the call site, so that it
+ *  is registered only the first time:
+ *  \code
+ *  static const LogFormat moved("unit {} moved to ({},{})");
+ *  channel.log(10, moved, id, x, y);
+ *  \endcode
+ *  Identifiers are never reused. A %LogFormat must outlive the logs issued
+ *  with it: the Logger cannot build the text of a log whose format is gone.
+**/
+class fndts::alf::LogFormat
+{
+    private:
+        static std::vector<const LogFormat*> formats;   /* Formats by id-1 */
+        static fndts::os::MutexThread mutex;    /* Mutex for the formats */
+
+        std::string format;     /* The format text */
+        uint32_t id;            /* The identifier of the format */
+
+        /* Copy constructor and assignment operator disabled */
+        LogFormat(const LogFormat & src) {}
+        LogFormat & operator = (const LogFormat & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Registers a format.
+         *  \param  f   The format text, with a <tt>{}</tt> for each argument.
+        **/
+        explicit LogFormat(const char *f);
+
+        /**
+         *  \brief  Unregisters the format. Its identifier is not reused.
+        **/
+        ~LogFormat();
+
+        /**
+         *  \brief  Gets the identifier written in the logs.
+         *  \return The identifier, never 0.
+        **/
+        inline const uint32_t getId() const
+        { return id; }
+
+        /**
+         *  \brief  Gets the format text.
+         *  \return The format text.
+        **/
+        inline const std::string & getFormat() const
+        { return format; }
+
+        /**
+         *  \brief  Builds the text of a log from its arguments.
+         *  \param  b   The first argument, as written by tLogArg.
+         *  \param  e   The end of the arguments.
+         *  \return The text of the log.
+        **/
+        const std::string toText(const comms::tByte *b,
+                                 const comms::tByte *e) const;
+
+        /**
+         *  \brief  Finds a registered format.
+         *  \param  i   The identifier of the format.
+         *  \return The format; NULL if there is none with that identifier.
+        **/
+        static const LogFormat * find(const uint32_t i);
+};
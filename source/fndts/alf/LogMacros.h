@@ -0,0 +1,97 @@
+// Foundations library (alf-another logging facility): ALF macros -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the ALF Library. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file LogMacros.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  Macros issuing logs only when their level is enabled.
+ *
+ *  A log issued with these macros costs nothing when disabled: the level is
+ *  checked before the arguments are evaluated, and logs with a constant level
+ *  lower than ALF_MIN_LEVEL are removed by the compiler. Define ALF_MIN_LEVEL
+ *  before including this file, or in the compiler flags, to strip the debug
+ *  logs of a release build:
+ *  \code
+ *  #define ALF_MIN_LEVEL 20
+ *  #include "alf/LogMacros.h"
+ *
+ *  ALF_LOG(channel, 10, "step {} of {}", i, n);        // removed
+ *  ALF_LOG(channel, 30, "unit {} destroyed", id);      // checked at run time
+ *  ALF_TEXT(channel, 30, describe(unit));              // called if enabled
+ *  \endcode
+ *  The level given to the macros is evaluated more than once.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "LogChannel.h"
+#include "LogFormat.h"
+
+/** \ingroup alf **/
+/**@{**/
+
+#ifndef ALF_MIN_LEVEL
+/** \brief Logs of a lower level are removed at compile time. **/
+#define ALF_MIN_LEVEL 0
+#endif
+
+/**
+ *  \brief Tells whether a log of level l would be issued by the channel c.
+**/
+#define ALF_ENABLED(c, l)                                                      \
+    ((l) >= ALF_MIN_LEVEL && (c).isEnabled(l))
+
+/**
+ *  \brief Issues a binary log (see LogFormat) of level l through the channel
+ *         c. The format f must be a string literal; it is registered the
+ *         first time the log is issued. The arguments are evaluated only
+ *         when the log is enabled.
+**/
+#define ALF_LOG(c, l, f, ...)                                                  \
+    do                                                                         \
+    {                                                                          \
+        if (ALF_ENABLED(c, l))                                                 \
+        {                                                                      \
+            static const fndts::alf::LogFormat __alf_format(f);               \
+            (c).log((l), __alf_format, ##__VA_ARGS__);                         \
+        }                                                                      \
+    } while (0)
+
+/**
+ *  \brief Issues the text t with level l through the channel c. The text is
+ *         evaluated only when the log is enabled.
+**/
+#define ALF_TEXT(c, l, t)                                                      \
+    do                                                                         \
+    {                                                                          \
+        if (ALF_ENABLED(c, l)) (c).log((l), (t));                              \
+    } while (0)
+
+/**
+ *  \brief Issues the warning t through the channel c. The text is evaluated
+ *         only when warnings are enabled.
+**/
+#define ALF_WARNING(c, t)                                                      \
+    do                                                                         \
+    {                                                                          \
+        if ((c).getWarningFlag()) (c).warning(t);                              \
+    } while (0)
+
+/**
+ *  \brief Issues the error t through the channel c. The text is evaluated
+ *         only when errors are enabled.
+**/
+#define ALF_ERROR(c, t)                                                        \
+    do                                                                         \
+    {                                                                          \
+        if ((c).getErrorFlag()) (c).error(t);                                  \
+    } while (0)
+
+/**@} ingroup alf **/
@@ -0,0 +1,232 @@
+// Foundations library (alf-another logging facility): LogRing -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+
+/**
+ *  \file LogRing.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %LogRing class implementation file.
+**/
+
+#include "LogRing.h"
+#include "Logger.h"
+#include "Log.h"
+#include "misc/Exception.h"
+#include "os/thread/Thread.h"
+#include "os/time/Clock.h"
+#include <sched.h>
+#include <sstream>
+
+using namespace fndts::alf;
+
+/* Size of the ring of each thread */
+#define LOG_RING_SIZE   (64 * 1024)
+
+/* Longest wait for the Logger to make room, in nanoseconds */
+#define LOG_MAXSTALL    1000000000ULL
+
+/* Ring of the calling thread */
+static __thread LogRing * __alf_threadRing = NULL;
+
+/* Record reserved out of the ring, when it does not fit in it */
+static __thread fndts::comms::tByte * __alf_spill = NULL;
+static __thread size_t __alf_spillSize = 0;
+
+/* -- Static member initialization ------------------------------------------ */
+std::vector<LogRing*>   LogRing::rings;
+fndts::os::MutexThread  LogRing::mutex;
+pthread_key_t           LogRing::key;
+pthread_once_t          LogRing::once = PTHREAD_ONCE_INIT;
+volatile int            LogRing::sleeping = 0;
+fndts::os::FutexThread  LogRing::doorbell;
+volatile unsigned long  LogRing::dropped = 0;
+
+/* -- Object methods -------------------------------------------------------- */
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: send
+// Writes a text log in the ring of the calling thread, unless it is dropped
+const bool LogRing::send(const eLogType k, const unsigned int l,
+                   const std::string & c, const std::string & t)
+{
+    LogRing *r = get();
+    const std::string & th = (r != NULL) ? r->thread :
+                             os::Thread::getSelf().getName();
+    fndts::comms::tByte *p = reserve(sizeof(uint32_t) + Log::byteSize(c,th,t));
+    if (p == NULL) return false;
+    uint32_t text = 0;
+    memcpy(p,&text,sizeof(text));
+    Log::toByteArray(p+sizeof(text),k,l,c,th,t);
+    commit();
+    return true;
+}
+
+// Private class method: reserve
+// Reserves the record in the ring of the calling thread, yielding while the
+// Logger makes room, up to LOG_MAXSTALL. A record too big for the ring is kept
+// apart to be sent through the common queue once the ring is empty, so that
+// the logs of a thread keep their order. Without a Logger to make room or to
+// read the queue, the record is dropped at once.
+fndts::comms::tByte * LogRing::reserve(const size_t sz)
+{
+    LogRing *r = get();
+    os::tNanos limit = 0;
+    if (r != NULL)
+    {
+        if (sz < r->ring.getCapacity() / 2)
+        {
+            fndts::comms::tByte *p;
+            while ((p = r->ring.reserve(sz)) == NULL)
+                if (!stall(limit)) return NULL;
+            return p;
+        }
+        while (r->ring.used() > 0)
+            if (!stall(limit)) return NULL;
+    }
+    if (Logger::singleton == NULL)
+    {
+        __sync_fetch_and_add(&dropped,1);
+        return NULL;
+    }
+    __alf_spill = new fndts::comms::tByte[sz];
+    __alf_spillSize = sz;
+    return __alf_spill;
+}
+
+// Private class method: commit
+// Makes the reserved record visible to the Logger, or sends it through the
+// common queue when it was kept apart
+void LogRing::commit()
+{
+    if (__alf_spill == NULL)
+    {
+        __alf_threadRing->ring.commit();
+        wake();
+        return;
+    }
+    const std::string & th = (__alf_threadRing != NULL) ?
+                             __alf_threadRing->thread :
+                             os::Thread::getSelf().getName();
+    Log log = toLog(__alf_spill,__alf_spillSize,th);
+    delete [] __alf_spill;
+    __alf_spill = NULL;
+    Logger::post(log);
+}
+
+// Private class method: stall
+// Yields while the Logger makes room. Gives up, dropping the log, when there
+// is no Logger or once the limit, set on the first call, has passed.
+const bool LogRing::stall(os::tNanos & limit)
+{
+    os::tNanos now = os::Clock::now();
+    if (limit == 0) limit = now + LOG_MAXSTALL;
+    if (Logger::singleton == NULL || now > limit)
+    {
+        __sync_fetch_and_add(&dropped,1);
+        return false;
+    }
+    sched_yield();
+    return true;
+}
+
+// Private class method: wake
+// Rings the doorbell if the Logger said it was going to sleep. The barrier
+// orders the record just issued before reading the flag; the Logger orders
+// the flag before looking for records the same way, so one of both sees the
+// other.
+void LogRing::wake()
+{
+    __sync_synchronize();
+    if (sleeping && __sync_bool_compare_and_swap(&sleeping,1,0))
+        doorbell.post();
+}
+
+// Private class method: toLog
+// Decodes a record. The text of a binary log is built from its format.
+Log LogRing::toLog(const fndts::comms::tByte *p, const size_t len,
+                   const std::string & th)
+{
+    uint32_t i, l;
+    memcpy(&i,p,sizeof(i));
+    if (i == 0) return Log(p+sizeof(i));
+
+    memcpy(&l,p+sizeof(i),sizeof(l));
+    std::string c(reinterpret_cast<const char *>(p+2*sizeof(i)));
+    const fndts::comms::tByte *args = p + headerSize(c);
+    const LogFormat *f = LogFormat::find(i);
+    if (f == NULL)
+    {
+        std::ostringstream t;
+        t << "(log with unknown format " << i << ")";
+        return Log(eSTANDARD,l,c,th,t.str());
+    }
+    return Log(eSTANDARD,l,c,th,f->toText(args,p+len));
+}
+
+// Private class method: get
+// Returns the ring of the calling thread, registering a new one on first use
+LogRing * LogRing::get()
+{
+    if (__alf_threadRing != NULL) return __alf_threadRing;
+
+    pthread_once(&once,createKey);
+    LogRing *r;
+    try
+    {
+        r = new LogRing();
+    }
+    catch (fndts::Exception & e)
+    {
+        return NULL;
+    }
+    mutex.lock();
+    rings.push_back(r);
+    mutex.unlock();
+    pthread_setspecific(key,r);
+    __alf_threadRing = r;
+    return r;
+}
+
+// Private class method: createKey
+// Creates the key whose destructor orphans the ring of an ending thread
+void LogRing::createKey()
+{
+    pthread_key_create(&key,orphan);
+}
+
+// Private class method: orphan
+// Leaves the ring of an ending thread to the Logger. The records committed
+// before are still drained.
+void LogRing::orphan(void *r)
+{
+    __sync_synchronize();
+    static_cast<LogRing *>(r)->orphaned = true;
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Private constructor: LogRing
+// Maps the ring and takes the name of the calling thread
+LogRing::LogRing()
+:
+    /* Attribute construction */
+    ring(LOG_RING_SIZE),
+    thread(os::Thread::getSelf().getName()),
+    orphaned(false)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Private destructor: ~LogRing
+// Unmaps the ring
+LogRing::~LogRing()
+{
+}
@@ -0,0 +1,155 @@
+// Foundations library (alf-another logging facility): LogRing class -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+/**
+ *  \file LogRing.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The ALF LogRing class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Log.h"
+#include "LogFormat.h"
+#include "comms/ByteRing.h"
+#include "os/thread/MutexThread.h"
+#include "os/thread/FutexThread.h"
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace alf {
+    class LogRing;
+    class Logger;
+    class LogChannel;
+} }
+
+/**
+ *  \ingroup alf
+ *  \brief  The ring where a thread leaves its logs for the Logger.
+ *
+ *  Each thread issuing logs gets its own %LogRing the first time it logs. The
+ *  thread is the only producer of its ring and the Logger thread the only
+ *  consumer, so a log is written with the lock free reserve()/commit() of
+ *  comms::ByteRing: threads logging at the same time neither take a lock nor
+ *  write to a shared cache line. The Logger drains the rings in turns.
+ *
+ *  Each ring remembers the name of its thread, which is thus looked up once.
+ *  When the thread ends, its ring is left to the Logger, which frees it once
+ *  empty. When a ring is full, the thread yields until the Logger makes room,
+ *  for one second at most; the log is dropped if no room is made by then, or
+ *  at once when there is no Logger (see getDroppedCount()). A log too big
+ *  for the ring is sent through the Logger's common Queue once the ring is
+ *  empty, so the logs of a thread keep their order.
+ *
+ *  The Logger thread sleeps when it finds nothing to drain. Before sleeping,
+ *  it raises a flag that the threads check after each log, so that the
+ *  first log written afterwards wakes it up. Only that log pays a system
+ *  call.
+ *
+ *  Each record starts with a 32 bits format identifier. A text log has the
+ *  identifier 0, followed by the Log bytes (see Log::toByteArray()). A
+ *  binary log has the identifier of its LogFormat, followed by the 32 bits
+ *  level, the channel name ending with the char 0 and the arguments (see
+ *  tLogArg); its text is built when the Logger decodes it.
+**/
+class fndts::alf::LogRing
+{
+    friend class Logger;
+    friend class LogChannel;
+
+    private:
+        static std::vector<LogRing*> rings; /* Rings of all the threads */
+        static fndts::os::MutexThread mutex;    /* Mutex for the rings */
+        static pthread_key_t key;       /* Orphans the ring of ending threads */
+        static pthread_once_t once;     /* Creates the key */
+        static volatile int sleeping;   /* The Logger waits for the doorbell */
+        static fndts::os::FutexThread doorbell; /* Wakes up the Logger */
+        static volatile unsigned long dropped;  /* Logs dropped */
+
+        comms::ByteRing ring;           /* The serialized logs */
+        std::string thread;             /* Name of the owner thread */
+        volatile bool orphaned;         /* The owner thread has ended */
+
+        /* Copy constructor and assignment operator disabled */
+        LogRing(const LogRing & src) {}
+        LogRing & operator = (const LogRing & src) { return *this; }
+
+        /* Creates the ring of the calling thread */
+        LogRing();
+
+        /* Destroys the ring */
+        ~LogRing();
+
+        /* Gets the ring of the calling thread; NULL if it cannot be mapped */
+        static LogRing * get();
+
+        /* Creates the thread key */
+        static void createKey();
+
+        /* Marks the ring of an ending thread */
+        static void orphan(void *r);
+
+        /* Reserves a record of sz bytes for the calling thread; NULL if the
+         * log is dropped */
+        static comms::tByte * reserve(const size_t sz);
+
+        /* Issues the reserved record */
+        static void commit();
+
+        /* Waits for room until the limit; false if the log is dropped */
+        static const bool stall(os::tNanos & limit);
+
+        /* Wakes up the Logger if it is sleeping */
+        static void wake();
+
+        /* Decodes a record of the thread th */
+        static Log toLog(const comms::tByte *p, const size_t len,
+                         const std::string & th);
+
+        /* Bytes before the arguments of a binary log */
+        static inline const size_t headerSize(const std::string & c)
+        { return 2 * sizeof(uint32_t) + c.size() + 1; }
+
+        /* Writes the bytes before the arguments of a binary log */
+        static inline comms::tByte * writeHeader(comms::tByte *b,
+                                                 const LogFormat & f,
+                                                 const uint32_t l,
+                                                 const std::string & c)
+        {
+            uint32_t i = f.getId();
+            memcpy(b,&i,sizeof(i));
+            memcpy(b+sizeof(i),&l,sizeof(l));
+            memcpy(b+2*sizeof(i),c.c_str(),c.size()+1);
+            return b + headerSize(c);
+        }
+
+    public:
+        /**
+         *  \brief  Issues a log to the Logger from the calling thread.
+         *  \param  k   The kind(type) of log. See eLogType.
+         *  \param  l   The level of the log.
+         *  \param  c   Channel that originated the log.
+         *  \param  t   Text of the log.
+         *  \return true if the log was issued; false if it was dropped.
+        **/
+        static const bool send(const eLogType k, const unsigned int l,
+                         const std::string & c, const std::string & t);
+
+        /**
+         *  \brief  Gets the number of logs dropped because the Logger did not
+         *          make room for them, or because there was no Logger.
+         *  \return The number of logs dropped.
+        **/
+        static inline const unsigned long getDroppedCount()
+        { return dropped; }
+};
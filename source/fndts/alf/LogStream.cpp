@@ -0,0 +1,325 @@
+// Foundations library (alf-another logging facility): LogStream -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+
+/**
+ *  \file LogStream.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %LogStream class implementation file.
+**/
+
+#include "LogStream.h"
+#include "LogChannel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace fndts::alf;
+
+/* Initial room of the scratch buffer of each thread */
+#define LOG_SCRATCH     256
+
+/* Scratch buffers of a thread: the text of a statement and the stream
+ * formatting its values */
+struct __alf_tScratch
+{
+    std::string text;
+    std::ostringstream format;
+};
+
+/* Scratch buffers of the calling thread, and whether a statement uses them */
+static __thread __alf_tScratch * __alf_scratch = NULL;
+static __thread bool __alf_scratchBusy = false;
+
+/* Frees the scratch buffer of ending threads */
+static pthread_key_t __alf_scratchKey;
+static pthread_once_t __alf_scratchOnce = PTHREAD_ONCE_INIT;
+
+static void __alf_freeScratch(void *s)
+{
+    delete static_cast<__alf_tScratch *>(s);
+    __alf_scratch = NULL;
+}
+
+static void __alf_createScratchKey()
+{
+    pthread_key_create(&__alf_scratchKey,__alf_freeScratch);
+}
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Private method: append
+// Appends the characters. Each new line issues the text before it.
+void LogStream::append(const char *s, const size_t n)
+{
+    const char *end = s + n;
+    const char *nl;
+    while ((nl = (const char *)memchr(s,'\n',end-s)) != NULL)
+    {
+        text->append(s,nl-s);
+        channel.log(level,*text);
+        text->clear();
+        s = nl + 1;
+    }
+    text->append(s,end-s);
+}
+
+// Private method: appendInteger
+// Writes the digits from the last one
+void LogStream::appendInteger(unsigned long long v, const bool negative)
+{
+    char buffer[24];
+    char *p = buffer + sizeof(buffer);
+    do
+    {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    if (negative) *--p = '-';
+    text->append(p,buffer+sizeof(buffer)-p);
+}
+
+// Private method: stream
+// The stream of the thread is reset; a nested statement gets its own one
+std::ostringstream & LogStream::stream()
+{
+    if (format != NULL) return *format;
+    if (text == &own)
+    {
+        format = new std::ostringstream();
+        return *format;
+    }
+    format = &__alf_scratch->format;
+    format->str("");
+    format->clear();
+    format->flags(std::ios_base::dec | std::ios_base::skipws);
+    format->precision(6);
+    format->width(0);
+    format->fill(' ');
+    return *format;
+}
+
+// Public operator: <<
+// Inserts a C string
+LogStream & LogStream::operator << (const char *v)
+{
+    if (format != NULL && v != NULL) insert(v);
+    else if (active && v != NULL) append(v,strlen(v));
+    return *this;
+}
+
+// Public operator: <<
+// Inserts a C string
+LogStream & LogStream::operator << (char *v)
+{
+    return *this << const_cast<const char *>(v);
+}
+
+// Public operator: <<
+// Inserts a string
+LogStream & LogStream::operator << (const std::string & v)
+{
+    if (format != NULL) insert(v);
+    else if (active) append(v.data(),v.size());
+    return *this;
+}
+
+// Public operator: <<
+// Inserts a character
+LogStream & LogStream::operator << (const char v)
+{
+    if (format != NULL) insert(v);
+    else if (active) append(&v,1);
+    return *this;
+}
+
+// Public operator: <<
+// Inserts a boolean as 1 or 0, as streams do
+LogStream & LogStream::operator << (const bool v)
+{
+    if (format != NULL) insert(v);
+    else if (active) text->push_back(v ? '1' : '0');
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const short v)
+{
+    if (format != NULL) insert(v);
+    else *this << (long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const unsigned short v)
+{
+    if (format != NULL) insert(v);
+    else *this << (unsigned long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const int v)
+{
+    if (format != NULL) insert(v);
+    else *this << (long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const unsigned int v)
+{
+    if (format != NULL) insert(v);
+    else *this << (unsigned long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const long v)
+{
+    if (format != NULL) insert(v);
+    else *this << (long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const unsigned long v)
+{
+    if (format != NULL) insert(v);
+    else *this << (unsigned long long)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const long long v)
+{
+    if (format != NULL) insert(v);
+    else if (active)
+    {
+        if (v < 0) appendInteger(0ULL - (unsigned long long)v,true);
+        else appendInteger(v,false);
+    }
+    return *this;
+}
+
+// Public operator: <<
+// Inserts an integer
+LogStream & LogStream::operator << (const unsigned long long v)
+{
+    if (format != NULL) insert(v);
+    else if (active) appendInteger(v,false);
+    return *this;
+}
+
+// Public operator: <<
+// Inserts a floating point number
+LogStream & LogStream::operator << (const float v)
+{
+    if (format != NULL) insert(v);
+    else *this << (double)v;
+    return *this;
+}
+
+// Public operator: <<
+// Inserts a floating point number with 6 significant digits, as streams do
+LogStream & LogStream::operator << (const double v)
+{
+    if (format != NULL) insert(v);
+    else if (active)
+    {
+        char buffer[32];
+        int n = snprintf(buffer,sizeof(buffer),"%g",v);
+        if (n > 0) text->append(buffer,n);
+    }
+    return *this;
+}
+
+// Public operator: <<
+// Applies a manipulator, such as std::endl, to the format stream
+LogStream & LogStream::operator << (std::ostream & (*m)(std::ostream &))
+{
+    if (active) insert(m);
+    return *this;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Private constructor: LogStream
+// Starts a statement with the default log level of the channel. It takes the
+// scratch buffer of the thread unless an enclosing statement has it.
+LogStream::LogStream(LogChannel & c)
+:
+    /* Attribute construction */
+    channel(c),
+    level(c.getDefaultLogLevel()),
+    text(NULL),
+    own(),
+    format(NULL),
+    active(c.isEnabled(level))
+{
+    if (!active) return;
+    if (__alf_scratchBusy)
+    {
+        text = &own;
+        return;
+    }
+    if (__alf_scratch == NULL)
+    {
+        pthread_once(&__alf_scratchOnce,__alf_createScratchKey);
+        __alf_scratch = new __alf_tScratch();
+        __alf_scratch->text.reserve(LOG_SCRATCH);
+        pthread_setspecific(__alf_scratchKey,__alf_scratch);
+    }
+    __alf_scratchBusy = true;
+    text = &__alf_scratch->text;
+}
+
+// Public constructor: LogStream
+// Takes over the statement of the source
+LogStream::LogStream(const LogStream & src)
+:
+    /* Attribute construction */
+    channel(src.channel),
+    level(src.level),
+    text(src.text),
+    own(src.own),
+    format(src.format),
+    active(src.active)
+{
+    if (src.text == &src.own) text = &own;
+    src.active = false;
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~LogStream
+// Issues the text left and gives the scratch buffers back
+LogStream::~LogStream()
+{
+    if (!active) return;
+    if (!text->empty()) channel.log(level,*text);
+    if (text == &own)
+        delete format;
+    else
+    {
+        text->clear();
+        __alf_scratchBusy = false;
+    }
+}
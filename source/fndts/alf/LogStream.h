@@ -0,0 +1,133 @@
+// Foundations library (alf-another logging facility): LogStream class -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+/**
+ *  \file LogStream.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The ALF LogStream class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace alf {
+    class LogStream;
+    class LogChannel;
+} }
+
+/**
+ *  \ingroup alf
+ *  \brief  The text of a statement inserting into a LogChannel with the
+ *          &lt;&lt; operator.
+ *
+ *  The first &lt;&lt; on a LogChannel returns a %LogStream, which the rest of
+ *  the statement inserts into. The text is appended to a scratch buffer of
+ *  the calling thread, reused from one statement to the next, so statements
+ *  of different threads do not share anything. Numbers are formatted in
+ *  place; other types, and manipulators, go through a std::ostringstream of
+ *  the thread too. Once the statement has used that stream, every value
+ *  after goes through it, so that manipulators such as std::hex,
+ *  std::setprecision or std::setw apply as they would on a stream. Their
+ *  effect lasts until the end of the statement.
+ *
+ *  Each line is issued with the default log level of the channel as soon as
+ *  its new line character is inserted. The text left at the end of the
+ *  statement is issued then, when the %LogStream is destroyed. When the
+ *  default log level is not enabled, nothing is formatted.
+**/
+class fndts::alf::LogStream
+{
+    friend class LogChannel;
+
+    private:
+        LogChannel & channel;   /* Channel issuing the lines */
+        unsigned int level;     /* Level of the lines */
+        std::string *text;      /* Text of the current line */
+        std::string own;        /* Text when the scratch buffer is taken */
+        std::ostringstream *format; /* Stream formatting the values, once
+                                     * used in the statement */
+        mutable bool active;    /* This object issues the text */
+
+        /* Assignment operator disabled */
+        LogStream & operator = (const LogStream & src) { return *this; }
+
+        /* Starts a statement on the channel c */
+        LogStream(LogChannel & c);
+
+        /* Appends n characters, issuing each complete line */
+        void append(const char *s, const size_t n);
+
+        /* Appends a formatted integer */
+        void appendInteger(unsigned long long v, const bool negative);
+
+        /* Gets the format stream, with the default format at its first use
+         * in the statement */
+        std::ostringstream & stream();
+
+        /* Formats a value through the format stream and appends it */
+        template <typename Type>
+        void insert(const Type & v)
+        {
+            std::ostringstream & s = stream();
+            s << v;
+            const std::string t = s.str();
+            s.str("");
+            append(t.data(),t.size());
+        }
+
+    public:
+        /**
+         *  \brief  Takes over the statement of another %LogStream, which will
+         *          not issue anything.
+         *  \param  src The %LogStream.
+        **/
+        LogStream(const LogStream & src);
+
+        /**
+         *  \brief  Issues the text after the last new line, if any.
+        **/
+        ~LogStream();
+
+        /**@{**/
+        /**
+         *  \brief  Inserts a value in the statement.
+         *  \param  v   The value.
+         *  \return This %LogStream.
+        **/
+        LogStream & operator << (const char *v);
+        LogStream & operator << (char *v);
+        LogStream & operator << (const std::string & v);
+        LogStream & operator << (const char v);
+        LogStream & operator << (const bool v);
+        LogStream & operator << (const short v);
+        LogStream & operator << (const unsigned short v);
+        LogStream & operator << (const int v);
+        LogStream & operator << (const unsigned int v);
+        LogStream & operator << (const long v);
+        LogStream & operator << (const unsigned long v);
+        LogStream & operator << (const long long v);
+        LogStream & operator << (const unsigned long long v);
+        LogStream & operator << (const float v);
+        LogStream & operator << (const double v);
+        LogStream & operator << (std::ostream & (*m)(std::ostream &));
+
+        template <typename Type>
+        LogStream & operator << (const Type & v)
+        {
+            if (active) insert(v);
+            return *this;
+        }
+        /**@}**/
+};
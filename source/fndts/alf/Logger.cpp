@@ -21,6 +21,7 @@
 #include "LogChannel.h"
 #include "Logger.h"
 #include "Log.h"
+#include "LogRing.h"
 #include "version.h"
 #include "os/thread/Thread.h"
 #include "os/thread/MutexThread.h"
@@ -32,9 +33,12 @@
 
 using namespace fndts::alf;
 
+/* Records handled from a ring before moving to the next one */
+#define LOG_DRAIN       64
+
 /* -- Static member initialization ------------------------------------------ */
 Logger *                          Logger::singleton = NULL;
-unsigned int                      Logger::glevel    = 0;
+volatile unsigned int             Logger::glevel    = 0;
 bool                              Logger::eflag     = true;
 bool                              Logger::wflag     = true;
 fndts::os::MutexThread            Logger::mutex;
@@ -43,7 +47,7 @@ std::map<std::string,LogChannel*> Logger::channels;
  * constructor (we use Queue as communications channel). Queue needs to do 
  * init stuff (create static objects) before calling the constructor.
  */
-fndts::comms::Channel *           Logger::ioport = NULL;
+fndts::comms::Queue *             Logger::ioport = NULL;
 
 /* -- Object methods -------------------------------------------------------- */
 
@@ -95,39 +99,101 @@ const bool Logger::closeLogChannel(const std::string n)
 }
 
 // Protected method: threadStartRoutine
-// Starts the logger thread (inherited)
+// Starts the logger thread (inherited). Drains the rings and the queue. When
+// both are empty, it raises the sleeping flag and looks once more; if there
+// is still nothing, it waits for the doorbell with no time limit (see
+// LogRing::wake()). On the exit command, the rings are emptied before
+// finishing.
 void * Logger::threadStartRoutine (void *arg)
 {
     bool finish = false;
+    bool idle = false;
     while (!finish)
     {
+        size_t n = drain();
         comms::Message msg;
-        if (Logger::ioport->receive(msg))
+        if (Logger::ioport->tryReceive(msg))
         {
-            /**
-             * \todo    Decide action to take when receive msg action fails:
-             *          finish normally, exception, ignore,... ?
-            **/
             Log log(msg);
-            switch (log.getType())
-            {
-                case eEXIT:     { exit(log); finish=true; break; }
-                case eERROR:    { error(log); break;             }
-                case eWARNING:  { warning(log); break;           }
-                case eSTANDARD: { standard(log); break;          }
-                default:
-                {
-                    std::cerr << "Logger thread: received incorrect message:\n";
-                    std::cerr << "  channel: " << log.getChannel() << "\n"
-                              << "  thread : " << log.getThreadName() << "\n"
-                              << "  level  : " << log.getLevel() << "\n"
-                              << "  type   : " << log.getType() << "\n"
-                              << "  text   : " << log.getLogText() << "\n";
-                    std::cerr.flush();
-                }
-            }
+            if (log.getType() == eEXIT) while (drain() > 0);
+            finish = handle(log);
+            n++;
+        }
+
+        if (n == 0 && !idle)
+        {
+            LogRing::sleeping = 1;
+            __sync_synchronize();
+            idle = true;
+        }
+        else if (idle)
+        {
+            /* Lower the flag, or take the ring of who already lowered it */
+            if (n == 0 || !__sync_bool_compare_and_swap(&LogRing::sleeping,1,0))
+                LogRing::doorbell.wait();
+            idle = false;
         }
     }
+    return NULL;
+}
+
+// Private object method: drain
+// Handles up to LOG_DRAIN records of each ring, in turns. The rings of the
+// threads gone are freed once empty.
+const size_t Logger::drain()
+{
+    size_t n = 0;
+    LogRing::mutex.lock();
+    std::vector<LogRing*>::iterator ite = LogRing::rings.begin();
+    while (ite != LogRing::rings.end())
+    {
+        LogRing *r = *ite;
+        bool orphaned = r->orphaned;
+        __sync_synchronize();
+
+        size_t k = 0, len;
+        const comms::tByte *p;
+        while (k < LOG_DRAIN && (p = r->ring.peek(len)) != NULL)
+        {
+            handle(LogRing::toLog(p,len,r->thread));
+            r->ring.release();
+            k++;
+        }
+        n += k;
+
+        if (orphaned && k < LOG_DRAIN)
+        {
+            delete r;
+            ite = LogRing::rings.erase(ite);
+        }
+        else ite++;
+    }
+    LogRing::mutex.unlock();
+    return n;
+}
+
+// Private object method: handle
+// Dispatches a log by its type
+const bool Logger::handle(const Log & log)
+{
+    switch (log.getType())
+    {
+        case eEXIT:     { exit(log); return true;    }
+        case eERROR:    { error(log); break;         }
+        case eWARNING:  { warning(log); break;       }
+        case eSTANDARD: { standard(log); break;      }
+        default:
+        {
+            std::cerr << "Logger thread: received incorrect message:\n";
+            std::cerr << "  channel: " << log.getChannel() << "\n"
+                      << "  thread : " << log.getThreadName() << "\n"
+                      << "  level  : " << log.getLevel() << "\n"
+                      << "  type   : " << log.getType() << "\n"
+                      << "  text   : " << log.getLogText() << "\n";
+            std::cerr.flush();
+        }
+    }
+    return false;
 }
 
 // Private object method: exit
@@ -180,6 +246,14 @@ void Logger::report(std::ostream & out, const Log & l) const
 
 /* -- Class methods --------------------------------------------------------- */
 
+// Private class method: post
+// Queues the log and rings the doorbell, as the thread may be sleeping
+void Logger::post(const Log & log)
+{
+    Logger::ioport->send(log.toMessage());
+    LogRing::wake();
+}
+
 // Public class method: getLogger
 // Creates the Logger object or returns a reference to the current existing one.
 // Implements the singleton pattern.
@@ -206,13 +280,6 @@ const char * Logger::getVersion()
     return ALF_VERSION;
 }
 
-// Public class method: getGlobalLevel
-// Returns the global log level
-unsigned int Logger::getGlobalLogLevel()
-{
-    return Logger::glevel;
-}
-
 // Public class method: setGlobalLevel
 // Sets a new global log level
 void Logger::setGlobalLogLevel(unsigned int l)
@@ -286,7 +353,7 @@ const bool Logger::close()
         Log exit(eEXIT,0,"Logger destructor","Destroying Logger object upon "
                  "close request. No more logging facilities available to the "
                  "program.\n");
-        Logger::ioport->send(exit.toMessage());
+        post(exit);
 
         /* Wait for the thread to finish */
         Logger::mutex.unlock();
@@ -333,7 +400,7 @@ Logger::~Logger()
     {
         /* Close and destroy the channel */
         Logger::ioport->close();
-        delete dynamic_cast<comms::Queue*>(Logger::ioport);
+        delete Logger::ioport;
 
         /* Destoy all log channels */
         std::map<std::string,LogChannel*>::iterator ite;
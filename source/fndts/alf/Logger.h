@@ -20,6 +20,7 @@
 #include "os/thread/Thread.h"
 #include "os/thread/MutexThread.h"
 #include "comms/Channel.h"
+#include "comms/Queue.h"
 #include <ostream>
 #include <map>
 
@@ -28,6 +29,7 @@ namespace fndts { namespace alf {
     class Logger; 
     class Log; 
     class LogChannel; 
+    class LogRing;
 } }
 
 /** 
@@ -58,8 +60,12 @@ namespace fndts { namespace alf {
  *
  *  \section ALF-LOGGER-2 Logger as Log reporter
  *  Communications between the %Logger object and the LogChannel object is 
- *  performed through Log objects sent through a common Queue. These Log objects
- *  will contain a type identifying the nature of the log:
+ *  performed through Log objects. Each thread writes its logs in its own
+ *  LogRing, which the %Logger thread drains in turns; logs not fitting in
+ *  the ring, and the exit command, are sent through a common Queue. When
+ *  there is nothing to drain, the %Logger thread sleeps until the next log
+ *  wakes it up. These Log objects will contain a type identifying the
+ *  nature of the log:
  *
  *      - eEXIT, to ask the %Logger thread to end.
  *      - eERROR, to ask the %Logger thread to issue an error report.
@@ -87,13 +93,15 @@ namespace fndts { namespace alf {
 **/
 class fndts::alf::Logger : public fndts::os::Thread
 {
+    friend class LogRing;
+
     private:
         /* LogChannels container */
         static std::map<std::string,LogChannel*> channels; 
-        static fndts::comms::Channel  *ioport; /* IO port for receiving logs */
+        static fndts::comms::Queue *ioport; /* IO port for receiving logs */
         static fndts::os::MutexThread mutex; /* Mutex for the object members */
         static Logger * singleton;    /* Singleton pattern driver */
-        static unsigned int glevel;   /* Global log level */
+        static volatile unsigned int glevel;  /* Global log level */
         static bool eflag, wflag;     /* error and warning flags to filter */
 
         /** 
@@ -108,6 +116,12 @@ class fndts::alf::Logger : public fndts::os::Thread
         **/
         virtual ~Logger();
         
+        /* Handles the records of the rings in turns. Returns how many. */
+        const size_t drain();
+
+        /* Handles a log. Returns true on the exit command. */
+        const bool handle(const Log & log);
+
         /* Methods to manage messages received from LogChannels */
         void exit (const Log & log) const;
         void error (const Log & log) const;
@@ -115,6 +129,10 @@ class fndts::alf::Logger : public fndts::os::Thread
         void standard (const Log & log) const;
         void report(std::ostream & out, const Log & log) const;
 
+        /* Sends a log through the common queue and wakes up the thread. All
+         * the logs not written in a LogRing must go through here. */
+        static void post(const Log & log);
+
     public:
         /**
          *  \brief  Checks if a given LogChannel exists.
@@ -135,13 +153,6 @@ class fndts::alf::Logger : public fndts::os::Thread
         **/
         virtual void * threadStartRoutine(void *arg);
 
-         /**
-          *  \brief  Gets the communications port/channel.
-          *  \return The %Logger's channel.
-         **/
-         static inline fndts::comms::Channel & getIOPort()
-         { return *ioport; }
-
         /** 
          *  \brief Sets the global log level of the %Logger object. 
          *  \param l New global log level for the %Logger object.
@@ -152,7 +163,8 @@ class fndts::alf::Logger : public fndts::os::Thread
          * \brief Returns the global log level of the %Logger object. 
          * \return An unsigned integer containing the global log level.
         **/
-        static unsigned int getGlobalLogLevel();
+        static inline unsigned int getGlobalLogLevel()
+        { return glevel; }
 
         /**
          *  \brief  Gets the error flag.
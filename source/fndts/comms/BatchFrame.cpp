@@ -0,0 +1,110 @@
+// Communications library (COMMS): BatchFrame class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   BatchFrame.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %BatchFrame class implementation file.
+**/
+
+#include <string.h>
+#include "BatchFrame.h"
+#include "Message.h"
+#include "Channel.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+const size_t BatchFrame::OVERHEAD;
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: add
+// Appends the length, the header and the bytes of the message and updates
+// the count. An empty frame takes the message whatever its size.
+const bool BatchFrame::add(const Message & m)
+{
+    size_t sz = m.size();
+    size_t at = buffer.size();
+    if (count > 0 && at + OVERHEAD + sz > maxsize) return false;
+
+    uint32_t len = sz;
+    buffer.resize(at + OVERHEAD + sz);
+    memcpy(&buffer[at], &len, sizeof(len));
+    memcpy(&buffer[at + sizeof(len)], &m.getHeader(), sizeof(tMessageHeader));
+    if (sz > 0) memcpy(&buffer[at + OVERHEAD], m.getData(), sz);
+    count++;
+    memcpy(&buffer[0], &count, sizeof(count));
+    return true;
+}
+
+// Public method: clear
+// Leaves only the count, set to 0
+void BatchFrame::clear()
+{
+    count = 0;
+    buffer.resize(sizeof(count));
+    memcpy(&buffer[0], &count, sizeof(count));
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: unpack
+// Walks the frame checking every length against the frame size
+const size_t BatchFrame::unpack(const tByte *p, const size_t sz, Channel & c)
+{
+    uint32_t n;
+    if (sz < sizeof(n)) return 0;
+    memcpy(&n, p, sizeof(n));
+
+    size_t at = sizeof(n);
+    size_t sent = 0;
+    Message m;
+    tMessageHeader h;
+    for (uint32_t i=0; i<n; i++)
+    {
+        uint32_t len;
+        if (at + OVERHEAD > sz) break;
+        memcpy(&len, p + at, sizeof(len));
+        memcpy(&h, p + at + sizeof(len), sizeof(h));
+        at += OVERHEAD;
+        if (at + len > sz) break;
+        if (len > 0)
+            m.fromByteArray(len, p + at);
+        else
+            m = Message();
+        m.setHeader(h);
+        at += len;
+        if (c.send(m)) sent++;
+    }
+    return sent;
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: BatchFrame
+// Reserves the whole frame once
+BatchFrame::BatchFrame(const size_t mx)
+:
+    /* Attribute construction */
+    buffer(),
+    maxsize(mx),
+    count(0)
+{
+    buffer.reserve(mx);
+    clear();
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~BatchFrame
+// Does nothing
+BatchFrame::~BatchFrame()
+{
+}
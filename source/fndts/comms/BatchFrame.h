@@ -0,0 +1,113 @@
+// Foundations library (fndts): BatchFrame class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   BatchFrame.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %BatchFrame class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Message.h"
+#include <stdint.h>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class BatchFrame;
+    class Channel;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   Packs many small messages in a single transport frame.
+ *
+ *  The frame is a 32 bits count of messages followed, for each message, by
+ *  its 32 bits length, its header (see tMessageHeader) and its bytes, in
+ *  host byte order. Messages keep the order they were added in. The frame
+ *  never grows above the maximum size given when created, but to hold a
+ *  single message bigger than that: such a message is only added to an
+ *  empty frame, which is then full.
+**/
+class fndts::comms::BatchFrame
+{
+    private:
+        std::vector<tByte> buffer;  /* The frame */
+        size_t maxsize;             /* Biggest size of the frame */
+        uint32_t count;             /* Messages in the frame */
+
+        /* Copy constructor and operator = disabled */
+        BatchFrame(const BatchFrame & src) {}
+        BatchFrame & operator = (const BatchFrame & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Bytes added to the frame for each message.
+        **/
+        static const size_t OVERHEAD = sizeof(uint32_t)
+                                       + sizeof(tMessageHeader);
+
+        /**
+         *  \brief  Creates an empty frame.
+         *  \param  mx  Biggest size of the frame in bytes.
+        **/
+        explicit BatchFrame(const size_t mx);
+
+        /**
+         *  \brief  Destroys the frame.
+        **/
+        virtual ~BatchFrame();
+
+        /**
+         *  \brief  Appends a message to the frame.
+         *  \param  m   The message.
+         *  \return true if added; false if it does not fit (never for an
+         *          empty frame).
+        **/
+        const bool add(const Message & m);
+
+        /**
+         *  \brief  Empties the frame.
+        **/
+        void clear();
+
+        /**
+         *  \brief  Gets the number of messages in the frame.
+         *  \return The number of messages.
+        **/
+        inline const size_t getCount() const
+        { return count; }
+
+        /**
+         *  \brief  Gets the frame bytes.
+         *  \return The frame.
+        **/
+        inline const tByte * data() const
+        { return &buffer[0]; }
+
+        /**
+         *  \brief  Gets the size of the frame.
+         *  \return The size in bytes.
+        **/
+        inline const size_t size() const
+        { return buffer.size(); }
+
+        /**
+         *  \brief  Sends the messages packed in a frame to a channel.
+         *  \param  p   The frame.
+         *  \param  sz  Size of the frame.
+         *  \param  c   The channel.
+         *  \return The number of messages sent; a malformed frame is only
+         *          unpacked up to the first broken message.
+        **/
+        static const size_t unpack(const tByte *p, const size_t sz,
+                                   Channel & c);
+};
@@ -0,0 +1,103 @@
+// Communications library (COMMS): Bridge class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Bridge.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Bridge class implementation file.
+**/
+
+#include "Bridge.h"
+#include "BatchFrame.h"
+#include "Message.h"
+#include "Queue.h"
+#include "SysQueue.h"
+
+using namespace fndts::comms;
+
+/* Time the bridge waits for a message before checking whether to stop */
+#define BRIDGE_POLL     100000000ULL
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Protected method: threadStartRoutine
+// Waits for a message, packs it with all the messages already queued behind
+// it and sends the frame. A message not fitting in the frame is kept for the
+// next one. A message bigger than a frame goes alone in its frame, which the
+// SysQueue fragments.
+void * Bridge::threadStartRoutine(void *arg)
+{
+    BatchFrame frame(framesize);
+    Message m;
+    bool pending = false;
+    for (;;)
+    {
+        if (!pending && !source.receive(m, BRIDGE_POLL))
+        {
+            if (stopping) break;
+            continue;
+        }
+        pending = false;
+
+        /* An empty frame takes any message */
+        frame.add(m);
+        while (source.tryReceive(m))
+        {
+            if (!frame.add(m))
+            {
+                pending = true;
+                break;
+            }
+        }
+
+        if (target.send(type, frame.size(), frame.data()))
+        {
+            __sync_fetch_and_add(&frames, 1);
+            __sync_fetch_and_add(&messages, frame.getCount());
+        }
+        else
+            __sync_fetch_and_add(&dropped, frame.getCount());
+        frame.clear();
+    }
+    return NULL;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Bridge
+// The frame size is bounded by the system limit
+Bridge::Bridge(const std::string & n, Queue & s, SysQueue & t,
+               const long ty, const size_t mx)
+:
+    /* Attribute construction */
+    source(s),
+    target(t),
+    type(ty),
+    framesize(SysQueue::getMaxPayloadSize()),
+    stopping(false),
+    frames(0),
+    messages(0),
+    dropped(0),
+
+    /* Superclass construction */
+    Thread(n)
+{
+    if (mx > 0 && mx < framesize) framesize = mx;
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Bridge
+// Does nothing
+Bridge::~Bridge()
+{
+}
@@ -0,0 +1,118 @@
+// Foundations library (fndts): Bridge class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Bridge.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Bridge class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/thread/Thread.h"
+#include <string>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class Bridge;
+    class Queue;
+    class SysQueue;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A thread forwarding the messages of a Queue to a SysQueue packed
+ *           in batches.
+ *
+ *  The bridge waits for a message in the source queue and then takes all the
+ *  messages already waiting there, packing them in a BatchFrame up to the
+ *  biggest SysQueue payload that is not fragmented. The whole frame is sent
+ *  with a single msgsnd() call. Under load, many messages go in each system
+ *  call; when idle, a lone message is sent at once, without waiting to fill
+ *  a frame.
+ *  The order of the messages is kept.
+ *
+ *  On the other process, a BridgeReceiver unpacks the frames to a Channel.
+ *  A message bigger than a frame is sent alone in a frame of its own, which
+ *  the SysQueue splits in fragments.
+ *
+ *  Launch the bridge with launch(NULL). stop() makes it forward the messages
+ *  still in the source queue and finish.
+**/
+class fndts::comms::Bridge : public fndts::os::Thread
+{
+    private:
+        Queue & source;         /* Where messages come from */
+        SysQueue & target;      /* Where frames go to */
+        long type;              /* SysQueue type of the frames */
+        size_t framesize;       /* Biggest frame */
+        volatile bool stopping; /* stop() was called */
+        volatile unsigned long frames;      /* Frames sent */
+        volatile unsigned long messages;    /* Messages sent in frames */
+        volatile unsigned long dropped;     /* Messages not sent */
+
+        /* Copy constructor and operator = disabled */
+        Bridge(const Bridge & src):Thread("disabled"),source(src.source),
+                                   target(src.target) {}
+        Bridge & operator = (const Bridge & src) { return *this; }
+
+    protected:
+        /**
+         *  \brief  The bridge loop.
+         *  \param  arg Not used.
+         *  \return NULL
+        **/
+        virtual void * threadStartRoutine(void *arg);
+
+    public:
+        /**
+         *  \brief  Creates a bridge.
+         *  \param  n   Name of the thread.
+         *  \param  s   The source queue.
+         *  \param  t   The target system queue.
+         *  \param  ty  The SysQueue type of the frames (greater than 0).
+         *  \param  mx  Biggest frame in bytes (0 for the biggest payload not
+         *              fragmented by the SysQueue).
+        **/
+        Bridge(const std::string & n, Queue & s, SysQueue & t,
+               const long ty = 1, const size_t mx = 0);
+
+        /**
+         *  \brief  Destroys the bridge.
+        **/
+        virtual ~Bridge();
+
+        /**
+         *  \brief  Makes the bridge finish once the source queue is empty.
+        **/
+        inline void stop()
+        { stopping = true; }
+
+        /**
+         *  \brief  Gets the number of frames sent.
+         *  \return The number of frames (system calls).
+        **/
+        inline const unsigned long getFrameCount() const
+        { return frames; }
+
+        /**
+         *  \brief  Gets the number of messages sent.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getMessageCount() const
+        { return messages; }
+
+        /**
+         *  \brief  Gets the number of messages that could not be sent.
+         *  \return The number of dropped messages.
+        **/
+        inline const unsigned long getDroppedCount() const
+        { return dropped; }
+};
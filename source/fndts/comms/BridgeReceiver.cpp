@@ -0,0 +1,92 @@
+// Communications library (COMMS): BridgeReceiver class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   BridgeReceiver.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %BridgeReceiver class implementation file.
+**/
+
+#include "BridgeReceiver.h"
+#include "BatchFrame.h"
+#include "Channel.h"
+#include "ReceiveBuffer.h"
+#include "SysQueue.h"
+#include <stdint.h>
+#include <time.h>
+
+using namespace fndts::comms;
+
+/* Shortest and longest sleeps between polls of the system queue, in ns */
+#define BRIDGE_MINPOLL      10000UL
+#define BRIDGE_MAXPOLL      1000000UL
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Protected method: threadStartRoutine
+// Receives frames and unpacks them to the target. When there is none, it
+// sleeps, doubling the sleep up to the maximum. Once stopping, a last look
+// at the queue finding nothing ends the loop.
+void * BridgeReceiver::threadStartRoutine(void *arg)
+{
+    ReceiveBuffer buffer(SysQueue::getMaxPayloadSize());
+    unsigned long ns = BRIDGE_MINPOLL;
+    while (true)
+    {
+        bool last = stopping;
+        if (source.tryReceive(buffer, type))
+        {
+            __sync_fetch_and_add(&frames, 1);
+            size_t n = BatchFrame::unpack(buffer.data(), buffer.size(),
+                                          target);
+            __sync_fetch_and_add(&messages, n);
+            ns = BRIDGE_MINPOLL;
+            continue;
+        }
+        if (last) break;
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        nanosleep(&ts, NULL);
+        if (ns < BRIDGE_MAXPOLL) ns = (2*ns < BRIDGE_MAXPOLL) ?
+                                      2*ns : BRIDGE_MAXPOLL;
+    }
+    return NULL;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: BridgeReceiver
+// Keeps the queues
+BridgeReceiver::BridgeReceiver(const std::string & n, SysQueue & s,
+                               Channel & t, const long ty)
+:
+    /* Attribute construction */
+    source(s),
+    target(t),
+    type(ty),
+    stopping(false),
+    frames(0),
+    messages(0),
+
+    /* Superclass construction */
+    Thread(n)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~BridgeReceiver
+// Does nothing
+BridgeReceiver::~BridgeReceiver()
+{
+}
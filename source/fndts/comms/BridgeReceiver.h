@@ -0,0 +1,103 @@
+// Foundations library (fndts): BridgeReceiver class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   BridgeReceiver.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %BridgeReceiver class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/thread/Thread.h"
+#include <string>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class BridgeReceiver;
+    class Channel;
+    class SysQueue;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A thread receiving the frames sent by a Bridge and sending the
+ *           messages they hold to a Channel.
+ *
+ *  Frames are received in a ReceiveBuffer reused for all of them, so no
+ *  memory is allocated per frame. Messages are sent to the target channel in
+ *  the order they were packed.
+ *
+ *  The receiver polls the system queue without blocking, sleeping a little
+ *  longer each time it finds nothing, up to a millisecond. Launch it with
+ *  launch(NULL). stop() makes it receive the frames still queued and
+ *  finish.
+**/
+class fndts::comms::BridgeReceiver : public fndts::os::Thread
+{
+    private:
+        SysQueue & source;      /* Where frames come from */
+        Channel & target;       /* Where messages go to */
+        long type;              /* SysQueue type of the frames */
+        volatile bool stopping; /* stop() was called */
+        volatile unsigned long frames;      /* Frames received */
+        volatile unsigned long messages;    /* Messages unpacked */
+
+        /* Copy constructor and operator = disabled */
+        BridgeReceiver(const BridgeReceiver & src):Thread("disabled"),
+            source(src.source),target(src.target) {}
+        BridgeReceiver & operator = (const BridgeReceiver & src)
+        { return *this; }
+
+    protected:
+        /**
+         *  \brief  The receiver loop.
+         *  \param  arg Not used.
+         *  \return NULL
+        **/
+        virtual void * threadStartRoutine(void *arg);
+
+    public:
+        /**
+         *  \brief  Creates a receiver.
+         *  \param  n   Name of the thread.
+         *  \param  s   The system queue.
+         *  \param  t   The channel where messages are sent.
+         *  \param  ty  The SysQueue type of the frames (greater than 0).
+        **/
+        BridgeReceiver(const std::string & n, SysQueue & s, Channel & t,
+                       const long ty = 1);
+
+        /**
+         *  \brief  Destroys the receiver.
+        **/
+        virtual ~BridgeReceiver();
+
+        /**
+         *  \brief  Makes the receiver finish once the system queue has no
+         *          frame left.
+        **/
+        inline void stop()
+        { stopping = true; }
+
+        /**
+         *  \brief  Gets the number of frames received.
+         *  \return The number of frames.
+        **/
+        inline const unsigned long getFrameCount() const
+        { return frames; }
+
+        /**
+         *  \brief  Gets the number of messages unpacked.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getMessageCount() const
+        { return messages; }
+};
@@ -0,0 +1,219 @@
+// Communications library (COMMS): ByteRing class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ByteRing.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ByteRing class implementation file.
+**/
+
+#include "ByteRing.h"
+#include "Message.h"
+#include "misc/Exception.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace fndts::comms;
+
+/* Bytes of the record header: the length and padding up to 8 bytes */
+#define RECORD_HEADER   8
+
+/* Size of a huge page */
+#define HUGE_PAGE       (2 << 20)
+
+/* -- Static member initialization ------------------------------------------ */
+
+const uint32_t ByteRing::WRAP;
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Discards the pending records and wakes up a blocked receiver, which wakes
+// up the next one before failing.
+const bool ByteRing::close()
+{
+    closed = true;
+    consumer.lock();
+    __sync_synchronize();
+    head = tail;
+    consumer.unlock();
+    records.post(1);
+    return true;
+}
+
+// Public method: send
+// Copies the message header and payload into a new record
+const bool ByteRing::send(const Message & m)
+{
+    producer.lock();
+    tByte *p = reserve(sizeof(tMessageHeader) + m.size());
+    if (p == NULL)
+    {
+        producer.unlock();
+        return false;
+    }
+    memcpy(p, &m.getHeader(), sizeof(tMessageHeader));
+    m.toByteArray(p + sizeof(tMessageHeader));
+    commit();
+    producer.unlock();
+    records.post(1);
+    return true;
+}
+
+// Public method: receive
+// Waits for a committed record and copies it out of the ring
+const bool ByteRing::receive(Message & r)
+{
+    waitFor(records);
+    if (closed)
+    {
+        records.post(1);
+        return false;
+    }
+
+    consumer.lock();
+    size_t len;
+    const tByte *p = peek(len);
+    if (p == NULL || len < sizeof(tMessageHeader))
+    {
+        if (p != NULL) release();
+        consumer.unlock();
+        return false;
+    }
+    tMessageHeader h;
+    memcpy(&h, p, sizeof(h));
+    if (len > sizeof(h)) r.fromByteArray(len - sizeof(h), p + sizeof(h));
+    else r = Message();
+    r.setHeader(h);
+    release();
+    consumer.unlock();
+    return true;
+}
+
+// Public method: reserve
+// Finds room for the record after the tail, leaving a wrap marker and
+// starting over from the beginning when it does not fit before the end.
+tByte *ByteRing::reserve(const size_t len)
+{
+    if (closed || len >= WRAP) return NULL;
+
+    size_t rec = recordSize(len);
+    size_t t = tail;
+    size_t h = head;
+    size_t off = t & (capacity - 1);
+    size_t skip = (capacity - off < rec) ? capacity - off : 0;
+    if (t - h + skip + rec > capacity) return NULL;
+
+    if (skip > 0)
+    {
+        *(uint32_t *)(ring + off) = WRAP;
+        t += skip;
+        off = 0;
+    }
+    *(uint32_t *)(ring + off) = (uint32_t)len;
+    pending = t + rec;
+    return ring + off + RECORD_HEADER;
+}
+
+// Public method: commit
+// Publishes the record: its bytes must be visible before the new tail.
+void ByteRing::commit()
+{
+    __sync_synchronize();
+    tail = pending;
+}
+
+// Public method: peek
+// Reads the header of the record at the head, following the wrap marker.
+const tByte *ByteRing::peek(size_t & len)
+{
+    size_t h = head;
+    size_t t = tail;
+    __sync_synchronize();
+    if (h == t) return NULL;
+
+    size_t off = h & (capacity - 1);
+    uint32_t l = *(const uint32_t *)(ring + off);
+    if (l == WRAP)
+    {
+        h += capacity - off;
+        off = 0;
+        l = *(const uint32_t *)ring;
+    }
+    next = h + recordSize(l);
+    len = l;
+    return ring + off + RECORD_HEADER;
+}
+
+// Public method: release
+// Gives the room of the peeked record back to the producer once its bytes
+// have been read.
+void ByteRing::release()
+{
+    __sync_synchronize();
+    head = next;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: ByteRing
+// Maps the ring trying reserved huge pages first for big rings.
+ByteRing::ByteRing(const size_t sz)
+:
+    /* Attribute construction */
+    ring(NULL),
+    capacity(sysconf(_SC_PAGESIZE)),
+    huge(false),
+    head(0),
+    next(0),
+    tail(0),
+    pending(0),
+    closed(false),
+    records(),
+    producer(),
+    consumer(),
+
+    /* Superclass construction */
+    Channel("Byte Ring")
+{
+    while (capacity < sz) capacity <<= 1;
+
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (capacity >= HUGE_PAGE)
+    {
+        p = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge = (p != MAP_FAILED);
+    }
+#endif
+    if (p == MAP_FAILED)
+    {
+        p = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw fndts::Exception("ByteRing: cannot map the ring memory");
+#ifdef MADV_HUGEPAGE
+        if (capacity >= HUGE_PAGE) madvise(p, capacity, MADV_HUGEPAGE);
+#endif
+    }
+    ring = (tByte *)p;
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~ByteRing
+// Closes the ring and unmaps its memory
+ByteRing::~ByteRing()
+{
+    close();
+    munmap(ring, capacity);
+}
@@ -0,0 +1,164 @@
+// Foundations library (fndts): ByteRing class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ByteRing.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ByteRing class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/MutexThread.h"
+#include "os/thread/FutexThread.h"
+#include <stdint.h>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class ByteRing; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A message channel storing variable-length records inline in one
+ *           contiguous ring of bytes.
+ *
+ *  Each record is an 8 bytes header holding the 32 bits length, followed
+ *  by the payload padded to 8 bytes. Producers write the payload straight
+ *  into the ring and consumers read it in place, so there is no allocation
+ *  per message and consumers stream through sequential memory. A record
+ *  never wraps around the end of the ring: when it does not fit, a wrap
+ *  marker is left and the record is written at the beginning.
+ *
+ *  The ring is mapped with mmap. Rings of 2 MB or more are rounded to whole
+ *  huge pages and backed by them when the system has some reserved;
+ *  otherwise, transparent huge pages are requested.
+ *
+ *  reserve()/commit() and peek()/release() are the zero-copy interface. They
+ *  are lock free but only for a single producer and a single consumer
+ *  thread. send() and receive() copy from/to a Message and can be used by
+ *  many threads: producers and consumers are serialized by a mutex on each
+ *  side. send() does not block: it fails when the ring is full.
+ *
+ *  send() stores the message header (see tMessageHeader) in front of the
+ *  payload bytes of the record, and receive() restores it. Trace headers
+ *  (see Tracer) are not carried through a ring.
+**/
+class fndts::comms::ByteRing : public fndts::comms::Channel
+{
+    private:
+        tByte *ring;                    /* The mapped ring */
+        size_t capacity;                /* Bytes in the ring (power of 2) */
+        bool huge;                      /* Backed by reserved huge pages */
+        char padding0[64];
+        volatile size_t head;           /* Consumer position (free running) */
+        size_t next;                    /* Head after the peeked record */
+        char padding1[64];
+        volatile size_t tail;           /* Producer position (free running) */
+        size_t pending;                 /* Tail after the reserved record */
+        char padding2[64];
+        volatile bool closed;           /* The ring has been closed */
+        fndts::os::FutexThread records; /* Committed records count */
+        fndts::os::MutexThread producer;/* Serializes senders */
+        fndts::os::MutexThread consumer;/* Serializes receivers */
+
+        /* Copy constructor and assignment operator disabled */
+        ByteRing(const ByteRing & src):Channel("disabled") {}
+        ByteRing & operator = (const ByteRing & src) { return *this; }
+
+        /* Bytes taken by a record with the given payload length */
+        static inline const size_t recordSize(const size_t len)
+        { return (8 + len + 7) & ~((size_t)7); }
+
+    public:
+        /**
+         *  \brief  Length written in place of a record to skip to the start.
+        **/
+        static const uint32_t WRAP = 0xFFFFFFFF;
+
+        /**
+         *  \brief  Creates a ring.
+         *  \param  sz  Minimum size of the ring in bytes. It is rounded up to
+         *              a power of 2, at least one page.
+         *  \throw  fndts::Exception if the memory cannot be mapped.
+        **/
+        explicit ByteRing(const size_t sz = 1 << 20);
+
+        /**
+         *  \brief  Destroys the ring unmapping its memory.
+        **/
+        virtual ~ByteRing();
+
+        /**
+         *  \brief  Closes the ring. Pending records are discarded and blocked
+         *          receivers are woken up.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Copies a Message into the ring.
+         *  \param  m   Message to send.
+         *  \return true if sent; false if there is no room or it is closed.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Waits for a record and copies it to a Message.
+         *  \param  r   The received message will be written here.
+         *  \return true if everything ok; false, otherwise
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Reserves room for a record (single producer).
+         *  \param  len The length of the payload.
+         *  \return Where to write the payload; NULL if there is no room.
+        **/
+        tByte *reserve(const size_t len);
+
+        /**
+         *  \brief  Makes the reserved record visible to the consumer.
+        **/
+        void commit();
+
+        /**
+         *  \brief  Gets the oldest record without removing it (single
+         *          consumer). It does not wait.
+         *  \param  len The length of the payload will be written here.
+         *  \return The payload, valid until release(); NULL if empty.
+        **/
+        const tByte *peek(size_t & len);
+
+        /**
+         *  \brief  Removes the record returned by peek() from the ring.
+        **/
+        void release();
+
+        /**
+         *  \brief  Gets the size of the ring.
+         *  \return The capacity in bytes.
+        **/
+        inline const size_t getCapacity() const
+        { return capacity; }
+
+        /**
+         *  \brief  Tells whether the ring is backed by reserved huge pages.
+         *  \return true if it is; false, otherwise.
+        **/
+        inline const bool isHuge() const
+        { return huge; }
+
+        /**
+         *  \brief  Gets the bytes in use by pending records.
+         *  \return The bytes used.
+        **/
+        inline const size_t used() const
+        { return tail - head; }
+};
@@ -0,0 +1,133 @@
+// Communications library (COMMS): CaptureTap class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   CaptureTap.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %CaptureTap class implementation file.
+**/
+
+#include <string.h>
+#include "CaptureTap.h"
+#include "os/time/Clock.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Closes the wrapped channel and writes the buffered records
+const bool CaptureTap::close()
+{
+    flush();
+    return channel.close();
+}
+
+// Public method: send
+// Captures before sending, so the timestamp is the one of the send request
+const bool CaptureTap::send(const Message & m)
+{
+    if (capturing) capture(m, eCAPTURESENT);
+    return channel.send(m);
+}
+
+// Public method: receive
+// Captures after receiving
+const bool CaptureTap::receive(Message & r)
+{
+    if (!channel.receive(r)) return false;
+    if (capturing && receives) capture(r, eCAPTURERECEIVED);
+    return true;
+}
+
+// Public method: flush
+// Writes the buffered records to the file
+void CaptureTap::flush()
+{
+    mutex.lock();
+    flushBuffer();
+    mutex.unlock();
+    if (file != NULL) fflush(file);
+}
+
+// Private method: capture
+// Appends the record header and the message bytes to the buffer
+void CaptureTap::capture(const Message & m, const eCaptureDirection d)
+{
+    if (file == NULL) return;
+
+    tCaptureRecord h;
+    h.length = m.size();
+    h.direction = d;
+    h.message = m.getHeader();
+
+    /* Stamped under the mutex so that records are written in time order */
+    mutex.lock();
+    h.timestamp = fndts::os::Clock::now();
+    size_t at = buffer.size();
+    buffer.resize(at + sizeof(h) + h.length);
+    memcpy(&buffer[at], &h, sizeof(h));
+    if (h.length > 0) memcpy(&buffer[at + sizeof(h)], m.getData(), h.length);
+    records++;
+    if (buffer.size() >= buffersize) flushBuffer();
+    mutex.unlock();
+}
+
+// Private method: flushBuffer
+// Writes and empties the buffer. The mutex must be locked.
+void CaptureTap::flushBuffer()
+{
+    if (file != NULL && !buffer.empty())
+        fwrite(&buffer[0], 1, buffer.size(), file);
+    buffer.clear();
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: CaptureTap
+// Opens the capture file and writes its header
+CaptureTap::CaptureTap(Channel & c, const std::string & path, const bool r,
+                       const size_t bs)
+:
+    /* Attribute construction */
+    channel(c),
+    file(NULL),
+    buffer(),
+    buffersize(bs),
+    receives(r),
+    capturing(true),
+    records(0),
+    mutex(),
+
+    /* Superclass construction */
+    Channel("Capture tap of " + c.getName())
+{
+    buffer.reserve(bs);
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL) return;
+
+    tCaptureFileHeader h;
+    memcpy(h.magic, "FNDTSCAP", sizeof(h.magic));
+    h.version = 2;
+    h.reserved = 0;
+    fwrite(&h, sizeof(h), 1, file);
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~CaptureTap
+// Writes the buffered records and closes the file
+CaptureTap::~CaptureTap()
+{
+    flush();
+    if (file != NULL) fclose(file);
+}
@@ -0,0 +1,166 @@
+// Foundations library (fndts): CaptureTap class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   CaptureTap.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %CaptureTap class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/MutexThread.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class CaptureTap;
+
+    /**
+     *  \brief  Which way a captured message was going.
+    **/
+    enum eCaptureDirection
+    {
+        eCAPTURESENT     = 0,   /**< Sent through the tap. **/
+        eCAPTURERECEIVED = 1    /**< Received through the tap. **/
+    };
+
+    /**
+     *  \brief  The header of a capture file.
+    **/
+    struct tCaptureFileHeader
+    {
+        char magic[8];      /**< "FNDTSCAP" */
+        uint32_t version;   /**< Format version (2) */
+        uint32_t reserved;  /**< Always 0 */
+    };
+
+    /**
+     *  \brief  The header of each message in a capture file, followed by
+     *          the message bytes.
+    **/
+    struct tCaptureRecord
+    {
+        uint64_t timestamp; /**< When it was captured (fndts::os::Clock) */
+        uint32_t length;    /**< Bytes of the message */
+        uint32_t direction; /**< See eCaptureDirection */
+        tMessageHeader message; /**< Header of the message */
+    };
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A Channel wrapping another one and recording the messages sent
+ *           through it to a capture file.
+ *
+ *  The tap forwards every call to the wrapped channel. Each message sent
+ *  (and, optionally, each message received) is appended with its timestamp,
+ *  length, direction and header to an in-memory buffer, written to the file only when it
+ *  is full, so capturing costs a copy and no system call per message. The
+ *  file can be replayed with a Replayer.
+ *
+ *  Use the tap in place of the channel:
+ *  \code
+ *  Queue q;
+ *  CaptureTap tap(q, "traffic.cap");
+ *  tap.send(m);            // sent to q and captured
+ *  \endcode
+**/
+class fndts::comms::CaptureTap : public fndts::comms::Channel
+{
+    private:
+        Channel & channel;          /* The wrapped channel */
+        FILE *file;                 /* The capture file */
+        std::vector<tByte> buffer;  /* Records not written yet */
+        size_t buffersize;          /* Bytes buffered before writing */
+        bool receives;              /* Capture received messages too */
+        volatile bool capturing;    /* Recording is on */
+        unsigned long records;      /* Messages captured */
+        fndts::os::MutexThread mutex;   /* Mutex for the buffer */
+
+        /* Copy constructor and assignment operator disabled */
+        CaptureTap(const CaptureTap & src):Channel("disabled"),
+                                           channel(src.channel) {}
+        CaptureTap & operator = (const CaptureTap & src) { return *this; }
+
+        /* Appends a record to the buffer */
+        void capture(const Message & m, const eCaptureDirection d);
+
+        /* Writes the buffer to the file. The mutex must be locked. */
+        void flushBuffer();
+
+    public:
+        /**
+         *  \brief  Creates a tap.
+         *  \param  c   The channel to wrap.
+         *  \param  path    The capture file, truncated if it exists.
+         *  \param  r   Capture received messages as well as sent ones.
+         *  \param  bs  Bytes buffered before writing to the file.
+        **/
+        CaptureTap(Channel & c, const std::string & path, const bool r = false,
+                   const size_t bs = 1 << 20);
+
+        /**
+         *  \brief  Destroys the tap, writing the buffered records and closing
+         *          the file. The wrapped channel is not closed.
+        **/
+        virtual ~CaptureTap();
+
+        /**
+         *  \brief  Tells whether the capture file could be opened.
+         *  \return true if it is open; false, otherwise.
+        **/
+        inline const bool isOpen() const
+        { return file != NULL; }
+
+        /**
+         *  \brief  Turns recording on or off. Messages keep being forwarded.
+         *  \param  on  true to record.
+        **/
+        inline void setCapturing(const bool on)
+        { capturing = on; }
+
+        /**
+         *  \brief  Gets the number of messages captured.
+         *  \return The number of records.
+        **/
+        inline const unsigned long getRecordCount() const
+        { return records; }
+
+        /**
+         *  \brief  Writes the buffered records to the file.
+        **/
+        void flush();
+
+        /**
+         *  \brief  Closes the wrapped channel and writes the buffered records.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Captures a Message and sends it to the wrapped channel.
+         *  \param  m   Message to send.
+         *  \return The result of the wrapped channel.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Receives a Message from the wrapped channel, capturing it
+         *          if asked to.
+         *  \param  r   The received message will be written here.
+         *  \return The result of the wrapped channel.
+        **/
+        virtual const bool receive (comms::Message & r);
+};
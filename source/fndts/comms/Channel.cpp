@@ -30,7 +30,11 @@ using namespace fndts::comms;
 Channel::Channel (const std::string n)
 :
     /* Attributes construction */
-    name(n)
+    name(n),
+    queuelat(),
+    transitlat(),
+    strategy(NULL),
+    expired(0)
 {
 }
 
@@ -39,7 +43,11 @@ Channel::Channel (const std::string n)
 Channel::Channel (const char *n)
 :
     /* Attributes construction */
-    name(n)
+    name(n),
+    queuelat(),
+    transitlat(),
+    strategy(NULL),
+    expired(0)
 {
 }
 
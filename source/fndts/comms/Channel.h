@@ -17,6 +17,11 @@
 
 /* Include files */
 #include <string>
+#include "Message.h"
+#include "Tracer.h"
+#include "LatencyHistogram.h"
+#include "WaitStrategy.h"
+#include "os/thread/FutexThread.h"
 
 /* Namespace definition and forward declarations */
 namespace fndts { namespace comms { 
@@ -32,6 +37,10 @@ class fndts::comms::Channel
 {
     private:
         std::string name;
+        LatencyHistogram queuelat;      /* Time traced messages spent here */
+        LatencyHistogram transitlat;    /* Time since origin when leaving */
+        const WaitStrategy *strategy;   /* How consumers wait (NULL default) */
+        volatile unsigned long expired; /* Messages discarded past deadline */
 
         /* Copy constructor disabled. */
         Channel(const Channel & src);
@@ -50,6 +59,39 @@ class fndts::comms::Channel
         **/
         virtual ~Channel();
 
+        /**
+         *  \brief  Stamps a Message entering this channel, if it is traced.
+         *
+         *  Channels call it on the copy of the message they keep.
+         *
+         *  \param  m   The message.
+        **/
+        inline void traceEnqueue(fndts::comms::Message & m)
+        { if (m.getTrace() != NULL) Tracer::enqueue(m); }
+
+        /**
+         *  \brief  Stamps a Message leaving this channel, if it is traced, and
+         *          records its latencies in the channel histograms.
+         *  \param  m   The message.
+        **/
+        inline void traceDequeue(fndts::comms::Message & m)
+        { if (m.getTrace() != NULL) Tracer::dequeue(m,queuelat,transitlat); }
+
+        /**
+         *  \brief  Takes one message from a counter of available messages,
+         *          waiting as the wait strategy of the channel says.
+         *  \param  c   The counter.
+        **/
+        inline void waitFor(fndts::os::FutexThread & c)
+        { if (strategy != NULL) strategy->wait(c); else c.wait(); }
+
+        /**
+         *  \brief  Counts messages discarded because they expired.
+         *  \param  n   Number of expired messages.
+        **/
+        inline void countExpired(const unsigned long n)
+        { __sync_fetch_and_add(&expired, n); }
+
     public:
 
         /**
@@ -59,6 +101,49 @@ class fndts::comms::Channel
         inline const std::string getName() const
         { return name; }
 
+        /**
+         *  \brief  Gets the histogram of the time traced messages spent in
+         *          this channel (see Tracer).
+         *  \return The queue latency histogram.
+        **/
+        inline LatencyHistogram & getQueueLatency()
+        { return queuelat; }
+
+        /**
+         *  \brief  Gets the histogram of the time since their origin of the 
+         *          traced messages leaving this channel (see Tracer).
+         *  \return The transit latency histogram.
+        **/
+        inline LatencyHistogram & getTransitLatency()
+        { return transitlat; }
+
+        /**
+         *  \brief  Gets the number of messages this channel discarded
+         *          because their deadline passed before they were received.
+         *  \return The expired messages count.
+        **/
+        inline const unsigned long getExpiredCount() const
+        { return expired; }
+
+        /**
+         *  \brief  Sets how consumers of this channel wait for a message.
+         *
+         *  Only channels counting their messages with a FutexThread use it:
+         *  Queue, ConflatingQueue and ByteRing. By default (NULL), consumers
+         *  spin the counter spin count and then park.
+         *
+         *  \param  w   The strategy, which must outlive the channel; or NULL.
+        **/
+        inline void setWaitStrategy(const WaitStrategy *w)
+        { strategy = w; }
+
+        /**
+         *  \brief  Gets the wait strategy of this channel.
+         *  \return The strategy; NULL for the default one.
+        **/
+        inline const WaitStrategy * getWaitStrategy() const
+        { return strategy; }
+
         /**
          *  \brief  Closes this channel cancelling all pending communications.
         **/
@@ -0,0 +1,141 @@
+// Communications library (COMMS): ConflatingQueue class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ConflatingQueue.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ConflatingQueue class implementation file.
+**/
+
+#include "ConflatingQueue.h"
+#include "Message.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Closes the queue discarding pending messages. The counts of the pending
+// keys are left behind as stale and consumed by the receivers that find the
+// queue empty, so a count posted or taken meanwhile is not lost.
+const bool ConflatingQueue::close()
+{
+    mutex.lock();
+    stale += order.size();
+    order.clear();
+    latest.clear();
+    mutex.unlock();
+    return true;
+}
+
+// Public method: send
+// Sends the message with the key given by the key function
+const bool ConflatingQueue::send(const Message & m)
+{
+    return send(keyof(m), m);
+}
+
+// Public method: send
+// Replaces the pending message of the key or, if none, queues the key and
+// wakes up one receiver.
+const bool ConflatingQueue::send(const long k, const Message & m)
+{
+    mutex.lock();
+    std::map<long,Message>::iterator ite = latest.find(k);
+    if (ite != latest.end())
+    {
+        ite->second = m;
+        traceEnqueue(ite->second);
+        conflated++;
+        mutex.unlock();
+        return true;
+    }
+    ite = latest.insert(std::make_pair(k, m)).first;
+    traceEnqueue(ite->second);
+    order.push_back(k);
+    mutex.unlock();
+    keyavail.post(1);
+    return true;
+}
+
+// Public method: receive
+// Waits for a pending key and takes its message. A count left by a discarded
+// key is consumed and the receiver waits again.
+const bool ConflatingQueue::receive(Message & r)
+{
+    for (;;)
+    {
+        waitFor(keyavail);
+        mutex.lock();
+        if (!order.empty()) break;
+        if (stale == 0)
+        {
+            mutex.unlock();
+            return false;
+        }
+        stale--;
+        mutex.unlock();
+    }
+    std::map<long,Message>::iterator ite = latest.find(order.front());
+    order.pop_front();
+    r = ite->second;
+    latest.erase(ite);
+    mutex.unlock();
+    traceDequeue(r);
+    return true;
+}
+
+// Public method: size
+// Returns the number of pending keys
+const size_t ConflatingQueue::size()
+{
+    mutex.lock();
+    size_t sz = order.size();
+    mutex.unlock();
+    return sz;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: defaultKey
+// The type in the message header
+long ConflatingQueue::defaultKey(const Message & m)
+{
+    return m.getType();
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: ConflatingQueue
+// Creates an empty queue with the given key function
+ConflatingQueue::ConflatingQueue(tKeyFunction f)
+:
+    /* Attribute construction */
+    latest(),
+    order(),
+    keyof(f != NULL ? f : ConflatingQueue::defaultKey),
+    conflated(0),
+    stale(0),
+    keyavail(),
+    mutex(),
+
+    /* Superclass construction */
+    Channel("Conflating Queue")
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~ConflatingQueue
+// Closes the queue
+ConflatingQueue::~ConflatingQueue()
+{
+    close();
+}
@@ -0,0 +1,127 @@
+// Foundations library (fndts): ConflatingQueue class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ConflatingQueue.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ConflatingQueue class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/MutexThread.h"
+#include "os/thread/FutexThread.h"
+#include <deque>
+#include <map>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { 
+    class ConflatingQueue; 
+
+    /**
+     *  \brief  A function extracting the conflation key of a Message.
+    **/
+    typedef long (*tKeyFunction)(const Message & m);
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A queue keeping only the newest pending Message for each key.
+ *
+ *  When a message is sent with the same key as a message still pending in
+ *  the queue, the new one replaces the old one in place: it keeps the old
+ *  message's position in the queue. Consumers only see the latest value for
+ *  each key, and the number of pending messages is bounded by the number of
+ *  distinct keys. A slow consumer skips stale updates instead of falling
+ *  further behind.
+ *
+ *  Keys are given explicitly with send(key,m) or extracted from the message
+ *  by a key function. By default, the key of a message is its type (see
+ *  Message::getType()).
+**/
+class fndts::comms::ConflatingQueue : public fndts::comms::Channel
+{
+    private:
+        std::map<long,Message> latest;  /* Pending message for each key */
+        std::deque<long> order;         /* Keys in arrival order */
+        tKeyFunction keyof;             /* Key extraction function */
+        unsigned long conflated;        /* Messages replaced while pending */
+        size_t stale;                   /* Counts left by discarded keys */
+        fndts::os::FutexThread keyavail;/* Pending keys count */
+        fndts::os::MutexThread mutex;   /* Mutex for object members */
+
+        /* Copy constructor and assignment operator disabled */
+        ConflatingQueue(const ConflatingQueue & src):Channel("disabled") {}
+        ConflatingQueue & operator = (const ConflatingQueue & src) 
+        { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates a conflating queue.
+         *  \param  f   Key extraction function (NULL for the default one).
+        **/
+        explicit ConflatingQueue(tKeyFunction f = NULL);
+
+        /**
+         *  \brief  Destroys the queue.
+        **/
+        virtual ~ConflatingQueue();
+
+        /**
+         *  \brief  Closes the queue discarding pending messages.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message with the key given by the key function.
+         *  \param  m   Message to send.
+         *  \return true if all OK; false, otherwise.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Sends a Message with the given key, replacing the pending
+         *          one with the same key, if any.
+         *  \param  k   The key.
+         *  \param  m   Message to send.
+         *  \return true if all OK; false, otherwise.
+        **/
+        const bool send(const long k, const comms::Message & m);
+
+        /**
+         *  \brief  Receives the oldest pending key with its newest Message.
+         *  \param  r   The received message will be written here.
+         *  \return true if everything ok; false, otherwise
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Gets the number of messages dropped because a newer one
+         *          with the same key arrived before they were received.
+         *  \return The number of conflated messages.
+        **/
+        inline const unsigned long getConflatedCount() const
+        { return conflated; }
+
+        /**
+         *  \brief  Gets the number of pending keys.
+         *  \return The number of pending messages.
+        **/
+        const size_t size();
+
+        /**
+         *  \brief  The default key function.
+         *  \param  m   The message.
+         *  \return The type of the message.
+        **/
+        static long defaultKey(const Message & m);
+};
@@ -0,0 +1,157 @@
+// Communications library (COMMS): FiberQueue class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   FiberQueue.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %FiberQueue class implementation file.
+**/
+
+#include "FiberQueue.h"
+#include "Message.h"
+#include "os/fiber/Fiber.h"
+#include "os/fiber/FiberScheduler.h"
+
+using namespace fndts::comms;
+using fndts::os::Fiber;
+using fndts::os::FiberScheduler;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Discards the pending messages and resumes everybody waiting.
+const bool FiberQueue::close()
+{
+    cond.lock();
+    closed = true;
+    q.clear();
+    while (!receivers.empty()) wakeup(receivers);
+    while (!senders.empty()) wakeup(senders);
+    cond.signal();
+    cond.unlock();
+    return true;
+}
+
+// Public method: send
+// Waits for room in the queue and pushes the message, resuming one receiver.
+const bool FiberQueue::send(const Message &m)
+{
+    cond.lock();
+    while (!closed && capacity > 0 && q.size() >= capacity)
+        suspend(senders);
+    if (closed)
+    {
+        cond.unlock();
+        return false;
+    }
+    q.push_back(m);
+    traceEnqueue(q.back());
+    wakeup(receivers);
+    cond.unlock();
+    return true;
+}
+
+// Public method: receive
+// Waits for a message in the queue and copies it in the parameter, resuming
+// one sender waiting for room.
+const bool FiberQueue::receive(Message & r)
+{
+    cond.lock();
+    while (!closed && q.empty())
+        suspend(receivers);
+    if (closed)
+    {
+        cond.unlock();
+        return false;
+    }
+    r = q.front();
+    q.pop_front();
+    wakeup(senders);
+    cond.unlock();
+    traceDequeue(r);
+    return true;
+}
+
+// Public method: size
+// Returns the number of pending messages
+const size_t FiberQueue::size()
+{
+    cond.lock();
+    size_t sz = q.size();
+    cond.unlock();
+    return sz;
+}
+
+// Private method: suspend
+// Must be called with the mutex locked. A fiber registers itself in the list
+// and parks (the scheduler unlocks the mutex once it is switched out); a
+// thread waits in the condition. In both cases the mutex is locked again on 
+// return.
+void FiberQueue::suspend(std::deque<Fiber *> & waiters)
+{
+    Fiber *self = FiberScheduler::getCurrentFiber();
+    if (self != NULL)
+    {
+        waiters.push_back(self);
+        FiberScheduler::park(cond);
+        cond.lock();
+    }
+    else
+    {
+        threadwaiters++;
+        cond.wait();
+        threadwaiters--;
+    }
+}
+
+// Private method: wakeup
+// Must be called with the mutex locked. Resumes the first waiting fiber of
+// the list, if any, and the blocked threads, if any.
+void FiberQueue::wakeup(std::deque<Fiber *> & waiters)
+{
+    if (!waiters.empty())
+    {
+        Fiber *f = waiters.front();
+        waiters.pop_front();
+        f->getScheduler()->ready(*f);
+    }
+    if (threadwaiters > 0) cond.signal();
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: FiberQueue
+// Creates an empty queue with the given capacity
+FiberQueue::FiberQueue(const size_t c)
+:
+    /* Attribute construction */
+    q(),
+    capacity(c),
+    receivers(),
+    senders(),
+    threadwaiters(0),
+    closed(false),
+    cond(),
+
+    /* Superclass construction */
+    Channel("Fiber Queue")
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~FiberQueue
+// Closes the queue
+FiberQueue::~FiberQueue()
+{
+    close();
+}
@@ -0,0 +1,107 @@
+// Foundations library (fndts): FiberQueue class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   FiberQueue.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %FiberQueue class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/CondThread.h"
+#include "os/fiber/Fiber.h"
+#include <deque>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class FiberQueue; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A FIFO queue of Message objects whose send and receive suspend the
+ *           calling Fiber instead of blocking its thread.
+ *
+ *  When receive() is called from a Fiber and the queue is empty (or send() is
+ *  called and the queue is full), the fiber is parked in the queue and its
+ *  scheduler thread goes on running other fibers. The fiber is put back in
+ *  the run queue of its FiberScheduler as soon as a message (or a free slot)
+ *  is available for it. Waiting fibers are served in FIFO order and only one
+ *  of them is resumed per message.
+ *
+ *  The queue can also be used from plain Thread objects, which will block as
+ *  they do with a Queue.
+ *
+ *  A capacity can be given to bound the number of pending messages; senders
+ *  wait for free room when the queue is full. A capacity of 0 means
+ *  unbounded.
+**/
+class fndts::comms::FiberQueue : public fndts::comms::Channel
+{
+    private:
+        std::deque<Message> q;          /* The fifo queue of messages */
+        size_t capacity;                /* Maximum pending messages (0: inf) */
+        std::deque<fndts::os::Fiber *> receivers; /* Fibers waiting messages */
+        std::deque<fndts::os::Fiber *> senders;   /* Fibers waiting room */
+        unsigned int threadwaiters;     /* Threads blocked in the condition */
+        bool closed;                    /* The queue has been closed */
+        fndts::os::CondThread cond;     /* Mutex and condition for threads */
+
+        /* Copy constructor and assignment operator disabled */
+        FiberQueue(const FiberQueue & src):Channel("disabled") {}
+        FiberQueue & operator = (const FiberQueue & src) { return *this; }
+
+        /* Wakes one fiber of the list or the blocked threads. Locked. */
+        void wakeup(std::deque<fndts::os::Fiber *> & waiters);
+
+        /* Waits in the list (fibers) or in the condition (threads). Locked. */
+        void suspend(std::deque<fndts::os::Fiber *> & waiters);
+
+    public:
+        /**
+         *  \brief  Creates a queue.
+         *  \param  c   Capacity of the queue (0 for unbounded).
+        **/
+        explicit FiberQueue(const size_t c = 0);
+
+        /**
+         *  \brief  Destroys a queue.
+        **/
+        virtual ~FiberQueue();
+
+        /**
+         *  \brief  Closes the queue discarding pending messages. All the
+         *          waiting fibers and threads are resumed and fail.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message to this queue, suspending the caller while
+         *          the queue is full.
+         *  \param  m   Message to send.
+         *  \return true if all OK; false if the queue was closed.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Receives a Message from this queue, suspending the caller 
+         *          while the queue is empty.
+         *  \param  r   The received message will be written here.
+         *  \return true if everything ok; false if the queue was closed.
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Gets the number of pending messages.
+         *  \return The number of messages in the queue.
+        **/
+        const size_t size();
+};
@@ -0,0 +1,118 @@
+// Communications library (COMMS): Filter class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Filter.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Filter class implementation file.
+**/
+
+#include "Filter.h"
+#include "Message.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Private method: matchesField
+// Loads the field as a little endian integer and compares it masked.
+const bool Filter::matchesField(const Message & m) const
+{
+    const tByte *p = m.getData();
+    if (p == NULL || m.size() < (size_t)(low + high)) return false;
+    unsigned long long f = 0;
+    for (long i=high-1; i>=0; i--)
+        f = (f << 8) | p[low + i];
+    return (f & mask) == value;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: all
+Filter Filter::all()
+{
+    return Filter();
+}
+
+// Public class method: type
+Filter Filter::type(const long t)
+{
+    return Filter(eFILTERTYPE, t, t, 0, 0, NULL);
+}
+
+// Public class method: typeRange
+Filter Filter::typeRange(const long l, const long h)
+{
+    return Filter(eFILTERTYPE, l, h, 0, 0, NULL);
+}
+
+// Public class method: field
+// The size is clamped to 1..8 bytes
+Filter Filter::field(const size_t off, const size_t sz,
+                     const unsigned long long m, const unsigned long long v)
+{
+    long n = (sz < 1) ? 1 : ((sz > 8) ? 8 : sz);
+    return Filter(eFILTERFIELD, off, n, m, v & m, NULL);
+}
+
+// Public class method: function
+// A NULL function accepts everything
+Filter Filter::function(const tFilterFunction f)
+{
+    if (f == NULL) return Filter();
+    return Filter(eFILTERFUNCTION, 0, 0, 0, 0, f);
+}
+
+// Public class method: typeOf
+// The type in the message header
+const long Filter::typeOf(const Message & m)
+{
+    return m.getType();
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Filter
+// Accepts every message
+Filter::Filter()
+:
+    /* Attribute construction */
+    kind(eFILTERALL),
+    low(0),
+    high(0),
+    mask(0),
+    value(0),
+    userfunction(NULL)
+{
+}
+
+// Private constructor: Filter
+// Sets all the attributes
+Filter::Filter(const eFilterKind k, const long l, const long h,
+               const unsigned long long m, const unsigned long long v,
+               const tFilterFunction f)
+:
+    /* Attribute construction */
+    kind(k),
+    low(l),
+    high(h),
+    mask(m),
+    value(v),
+    userfunction(f)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Filter
+// Does nothing
+Filter::~Filter()
+{
+}
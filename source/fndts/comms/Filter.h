@@ -0,0 +1,173 @@
+// Foundations library (fndts): Filter class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Filter.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Filter class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Message.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class Filter;
+
+    /**
+     *  \brief  A user predicate on a Message.
+    **/
+    typedef bool (*tFilterFunction)(const Message & m);
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A compact predicate selecting the messages a Topic subscriber
+ *           wants.
+ *
+ *  A filter is a small value object evaluated by the publisher, with no
+ *  allocation nor virtual call. It accepts:
+ *   - every message (all()),
+ *   - the messages of a type or range of types, read from their header
+ *     (type(), typeRange()),
+ *   - the messages whose payload holds a value at some offset, after
+ *     masking (field()),
+ *   - the messages a user function accepts (function()).
+**/
+class fndts::comms::Filter
+{
+    public:
+        /**
+         *  \brief  The kinds of filter.
+        **/
+        enum eFilterKind
+        {
+            eFILTERALL,         /**< Accepts every message */
+            eFILTERTYPE,        /**< Message type in [low,high] */
+            eFILTERFIELD,       /**< Payload bytes & mask == value */
+            eFILTERFUNCTION     /**< User function */
+        };
+
+    private:
+        eFilterKind kind;       /* What to check */
+        long low;               /* Lowest type, or field offset */
+        long high;              /* Highest type, or field size */
+        unsigned long long mask;    /* Mask of the field */
+        unsigned long long value;   /* Expected masked field */
+        tFilterFunction userfunction;   /* User function */
+
+        /* Builds a filter of the given kind */
+        Filter(const eFilterKind k, const long l, const long h,
+               const unsigned long long m, const unsigned long long v,
+               const tFilterFunction f);
+
+    public:
+        /**
+         *  \brief  Creates a filter accepting every message.
+        **/
+        Filter();
+
+        /**
+         *  \brief  Destroys the filter.
+        **/
+        ~Filter();
+
+        /**
+         *  \brief  Gets the kind of the filter.
+         *  \return The kind.
+        **/
+        inline const eFilterKind getKind() const
+        { return kind; }
+
+        /**
+         *  \brief  Tells whether the message passes the filter.
+         *  \param  m   The message.
+         *  \param  t   The type of the message, read once by the caller.
+         *  \return true if it passes; false, otherwise.
+        **/
+        inline const bool matches(const Message & m, const long t) const
+        {
+            switch (kind)
+            {
+                case eFILTERALL:
+                    return true;
+                case eFILTERTYPE:
+                    return t >= low && t <= high;
+                case eFILTERFIELD:
+                    return matchesField(m);
+                default:
+                    return userfunction(m);
+            }
+        }
+
+        /**
+         *  \brief  Tells whether the message passes the filter.
+         *  \param  m   The message.
+         *  \return true if it passes; false, otherwise.
+        **/
+        inline const bool matches(const Message & m) const
+        { return matches(m, m.getType()); }
+
+        /**
+         *  \brief  Creates a filter accepting every message.
+         *  \return The filter.
+        **/
+        static Filter all();
+
+        /**
+         *  \brief  Creates a filter accepting the messages of a type.
+         *  \param  t   The type.
+         *  \return The filter.
+        **/
+        static Filter type(const long t);
+
+        /**
+         *  \brief  Creates a filter accepting a range of message types.
+         *  \param  l   The lowest type.
+         *  \param  h   The highest type.
+         *  \return The filter.
+        **/
+        static Filter typeRange(const long l, const long h);
+
+        /**
+         *  \brief  Creates a filter on a payload field.
+         *
+         *  The field is read as a little endian integer. Messages too short
+         *  to hold the field do not pass.
+         *
+         *  \param  off Offset of the field in the payload.
+         *  \param  sz  Size of the field in bytes (1 to 8).
+         *  \param  m   Mask applied to the field.
+         *  \param  v   Value the masked field must have.
+         *  \return The filter.
+        **/
+        static Filter field(const size_t off, const size_t sz,
+                            const unsigned long long m,
+                            const unsigned long long v);
+
+        /**
+         *  \brief  Creates a filter calling a user function.
+         *  \param  f   The function.
+         *  \return The filter.
+        **/
+        static Filter function(const tFilterFunction f);
+
+        /**
+         *  \brief  Gets the type filters check.
+         *  \param  m   The message.
+         *  \return The type in the header of the message.
+        **/
+        static const long typeOf(const Message & m);
+
+    private:
+        /* Checks a field filter */
+        const bool matchesField(const Message & m) const;
+};
@@ -0,0 +1,94 @@
+// Communications library (COMMS): LatencyHistogram class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   LatencyHistogram.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %LatencyHistogram class implementation file.
+**/
+
+#include "LatencyHistogram.h"
+
+using namespace fndts::comms;
+using fndts::os::tNanos;
+
+/* -- Static member initialization ------------------------------------------ */
+const unsigned int LatencyHistogram::BUCKETS;
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: record
+// Adds the latency to its bucket: the position of its highest set bit.
+void LatencyHistogram::record(const tNanos ns)
+{
+    unsigned int b = (ns == 0) ? 0 : 64 - __builtin_clzll(ns);
+    __sync_fetch_and_add(&buckets[b], 1);
+    __sync_fetch_and_add(&count, 1);
+    __sync_fetch_and_add(&sum, ns);
+
+    unsigned long long m = max;
+    while (ns > m)
+    {
+        unsigned long long prev = __sync_val_compare_and_swap(&max, m, ns);
+        if (prev == m) break;
+        m = prev;
+    }
+}
+
+// Public method: reset
+// Sets all the counters to 0
+void LatencyHistogram::reset()
+{
+    for (unsigned int i=0; i<BUCKETS; i++) buckets[i] = 0;
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+// Public method: getPercentile
+// Walks the buckets until the asked fraction of the latencies is reached
+const tNanos LatencyHistogram::getPercentile(const double p) const
+{
+    unsigned long long total = count;
+    if (total == 0) return 0;
+
+    unsigned long long target = static_cast<unsigned long long>(total*p/100.0);
+    if (target == 0) target = 1;
+    unsigned long long acc = 0;
+    for (unsigned int i=0; i<BUCKETS; i++)
+    {
+        acc += buckets[i];
+        if (acc >= target) 
+            return (i == 0) ? 0 : (i >= 64 ? max : (1ULL << i) - 1);
+    }
+    return max;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: LatencyHistogram
+// Creates an empty histogram
+LatencyHistogram::LatencyHistogram()
+:
+    /* Attribute construction */
+    count(0),
+    sum(0),
+    max(0)
+{
+    for (unsigned int i=0; i<BUCKETS; i++) buckets[i] = 0;
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~LatencyHistogram
+// Does nothing
+LatencyHistogram::~LatencyHistogram()
+{
+}
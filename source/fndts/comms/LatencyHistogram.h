@@ -0,0 +1,101 @@
+// Foundations library (fndts): LatencyHistogram class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   LatencyHistogram.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %LatencyHistogram class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/time/Clock.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class LatencyHistogram; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A histogram of latencies with power of two buckets.
+ *
+ *  Bucket 0 counts latencies of 0 ns and bucket i (i>0) counts latencies in
+ *  [2^(i-1), 2^i) ns. Recording is a few atomic increments, so several
+ *  threads may record in the same histogram without locking.
+**/
+class fndts::comms::LatencyHistogram
+{
+    public:
+        /** \brief  Number of buckets of the histogram. **/
+        static const unsigned int BUCKETS = 65;
+
+    private:
+        volatile unsigned long long buckets[BUCKETS];  /* Counts */
+        volatile unsigned long long count;  /* Recorded latencies */
+        volatile unsigned long long sum;    /* Sum of latencies */
+        volatile unsigned long long max;    /* Highest latency */
+
+    public:
+        /**
+         *  \brief  Creates an empty histogram.
+        **/
+        LatencyHistogram();
+
+        /**
+         *  \brief  Destroys the histogram.
+        **/
+        virtual ~LatencyHistogram();
+
+        /**
+         *  \brief  Records a latency.
+         *  \param  ns  The latency in nanoseconds.
+        **/
+        void record(const fndts::os::tNanos ns);
+
+        /**
+         *  \brief  Empties the histogram.
+        **/
+        void reset();
+
+        /**
+         *  \brief  Gets the number of recorded latencies.
+         *  \return The count of latencies.
+        **/
+        inline const unsigned long long getCount() const
+        { return count; }
+
+        /**
+         *  \brief  Gets the highest recorded latency.
+         *  \return The maximum in nanoseconds.
+        **/
+        inline const fndts::os::tNanos getMax() const
+        { return max; }
+
+        /**
+         *  \brief  Gets the mean of the recorded latencies.
+         *  \return The mean in nanoseconds (0 if empty).
+        **/
+        inline const fndts::os::tNanos getMean() const
+        { return count > 0 ? sum / count : 0; }
+
+        /**
+         *  \brief  Gets the count of a bucket.
+         *  \param  i   The bucket.
+         *  \return The number of latencies recorded in the bucket.
+        **/
+        inline const unsigned long long getBucket(const unsigned int i) const
+        { return i < BUCKETS ? buckets[i] : 0; }
+
+        /**
+         *  \brief  Gets an upper bound of the given percentile.
+         *  \param  p   The percentile, from 0 to 100.
+         *  \return The upper limit of the bucket reaching the percentile.
+        **/
+        const fndts::os::tNanos getPercentile(const double p) const;
+};
@@ -16,6 +16,7 @@
 
 #include <string.h> // for memcpy prototype
 #include "Message.h"
+#include "Tracer.h"
 
 using namespace fndts::comms;
 
@@ -43,12 +44,20 @@ void Message::toByteArray(tByte *array) const
 }
 
 // Public method: fromByteArray
-// Allocates a new array to hold the data stored in the given array.
+// Allocates a new array to hold the data stored in the given array. The
+// current array is reused if its size is the same as the new data's.
 void Message::fromByteArray(const size_t sz, const tByte *array)
 {
     /* Check size */
     if (sz <= 0) return;
 
+    /* Reuse the current array when it has the same size */
+    if (data != NULL && sz == msgsize)
+    {
+        memcpy (data,array,msgsize);
+        return;
+    }
+
     /* Deallocate previous data */
     if (data != NULL) delete []data;
 
@@ -58,6 +67,20 @@ void Message::fromByteArray(const size_t sz, const tByte *array)
     memcpy (data,array,msgsize);
 }
 
+// Public method: setTrace
+// Copies the given trace header, or removes the current one.
+void Message::setTrace(const tTraceHeader *h)
+{
+    if (h == NULL)
+    {
+        if (trace != NULL) delete trace;
+        trace = NULL;
+        return;
+    }
+    if (trace == NULL) trace = new tTraceHeader;
+    *trace = *h;
+}
+
 /* -- Class methods --------------------------------------------------------- */
 
 /* -- Constructors ---------------------------------------------------------- */
@@ -68,7 +91,9 @@ Message::Message()
 :
     /* Attribute construction */
     msgsize(0),
-    data(NULL)
+    data(NULL),
+    trace(NULL),
+    header()
 {
 }
 
@@ -78,7 +103,9 @@ Message::Message(const size_t sz, const tByte *array)
 :
     /* Attribute construction */
     msgsize(sz),
-    data(NULL)
+    data(NULL),
+    trace(NULL),
+    header()
 {
     data = new tByte[msgsize];
     if (array != NULL)
@@ -93,19 +120,25 @@ Message::Message(const Message & src)
 :
     /* Attribute construction */
     msgsize(src.size()),
-    data(NULL)
+    data(NULL),
+    trace(NULL),
+    header(src.header)
 {
     data = new tByte[msgsize];
     if (data != NULL) src.toByteArray(data);
+    if (src.trace != NULL) setTrace(src.trace);
 }
 Message::Message(Message & src)
 :
     /* Attribute construction */
     msgsize(src.size()),
-    data(NULL)
+    data(NULL),
+    trace(NULL),
+    header(src.header)
 {
     data = new tByte[msgsize];
     if (data != NULL) src.toByteArray(data);
+    if (src.trace != NULL) setTrace(src.trace);
 }
 
 /* -- Destructor ------------------------------------------------------------ */
@@ -115,6 +148,7 @@ Message::Message(Message & src)
 Message::~Message()
 {
     if (data != NULL) delete []data;
+    if (trace != NULL) delete trace;
 }
 
 /* -- Operators ------------------------------------------------------------- */
@@ -133,6 +167,10 @@ Message & Message::operator = (const Message & src)
     data = new tByte[msgsize];
     if (data != NULL) src.toByteArray(data);
 
+    /* Copy the trace and the header */
+    setTrace(src.trace);
+    header = src.header;
+
     return *this;
 }
 
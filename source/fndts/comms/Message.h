@@ -16,22 +16,58 @@
 #pragma once
 
 /* Include files */
+#include "os/time/Clock.h"
+#include <stddef.h>
+#include <stdint.h>
 
 /* Namespace definition and forward declarations */
 namespace fndts { namespace comms {
     class Message; 
+    struct tTraceHeader;
     typedef unsigned char tByte; 
+
+    /**
+     *  \brief  Flags of a message header.
+    **/
+    enum eMessageFlag
+    {
+        eMSGSEQUENCE  = 0x0001,     /**< The sequence number is set */
+        eMSGTIMESTAMP = 0x0002,     /**< The timestamp is set */
+        eMSGUSER      = 0x0100      /**< First flag free for the user */
+    };
+
+    /**
+     *  \brief  The fixed header of every Message, kept apart from the
+     *          payload and carried by all the channels.
+    **/
+    struct tMessageHeader
+    {
+        int64_t type;       /**< Type of the message; 0 when untyped */
+        uint32_t flags;     /**< Combination of eMessageFlag values */
+        uint32_t reserved;  /**< Always 0 */
+        uint64_t sequence;  /**< Sequence number (eMSGSEQUENCE) */
+        uint64_t timestamp; /**< Time stamp, see os::Clock (eMSGTIMESTAMP) */
+        uint64_t deadline;  /**< Expiry time; 0 when it never expires */
+    };
 } }
 
 /**
  *  \ingroup comms
  *  \brief   A message to be sent/received through a Channel.
+ *
+ *  Besides its payload, a message has a small header (see tMessageHeader)
+ *  with its type, flags, an optional sequence number and timestamp, and its
+ *  deadline. Channels carry the header with the payload, so receivers,
+ *  filters and dispatchers can decide what to do with a message without
+ *  decoding its payload.
 **/
 class fndts::comms::Message 
 {
     protected:
         tByte   *data;  /* The array where the data are sent from/received to */
         size_t  msgsize;    /* The size of the array */
+        tTraceHeader *trace;    /* Latency trace (NULL when not traced) */
+        tMessageHeader header;  /* Type, flags, sequence, time and deadline */
 
     public:
         /**@{**/
@@ -62,6 +98,13 @@ class fndts::comms::Message
         **/
         virtual const size_t size() const;
 
+        /**
+         *  \brief  Gets the message data without copying them.
+         *  \return The data; NULL if the message is empty.
+        **/
+        inline const tByte * getData() const
+        { return data; }
+
         /**
          *  \brief  Gets an array containing the message data.
          *
@@ -87,5 +130,149 @@ class fndts::comms::Message
          *  \param  src The %Message to copy from.
         **/
         virtual Message & operator = (const Message & src);
+
+        /**
+         *  \brief  Gets the header of the message.
+         *  \return The header.
+        **/
+        inline const tMessageHeader & getHeader() const
+        { return header; }
+
+        /**
+         *  \brief  Replaces the header of the message.
+         *  \param  h   The new header.
+        **/
+        inline void setHeader(const tMessageHeader & h)
+        { header = h; }
+
+        /**
+         *  \brief  Gets the type of the message.
+         *  \return The type; 0 when untyped.
+        **/
+        inline const long getType() const
+        { return header.type; }
+
+        /**
+         *  \brief  Sets the type of the message.
+         *  \param  type    The new type.
+        **/
+        inline void setType(const long type)
+        { header.type = type; }
+
+        /**
+         *  \brief  Gets the flags of the message.
+         *  \return The flags (see eMessageFlag).
+        **/
+        inline const uint32_t getFlags() const
+        { return header.flags; }
+
+        /**
+         *  \brief  Sets the flags of the message.
+         *  \param  f   The flags (see eMessageFlag).
+        **/
+        inline void setFlags(const uint32_t f)
+        { header.flags = f; }
+
+        /**
+         *  \brief  Sets the sequence number of the message.
+         *  \param  s   The sequence number.
+        **/
+        inline void setSequence(const uint64_t s)
+        { header.sequence = s; header.flags |= eMSGSEQUENCE; }
+
+        /**
+         *  \brief  Gets the sequence number of the message.
+         *  \return The sequence number; 0 if not set.
+        **/
+        inline const uint64_t getSequence() const
+        { return header.sequence; }
+
+        /**
+         *  \brief  Tells whether the sequence number is set.
+         *  \return true if set.
+        **/
+        inline const bool hasSequence() const
+        { return (header.flags & eMSGSEQUENCE) != 0; }
+
+        /**
+         *  \brief  Sets the timestamp of the message.
+         *  \param  t   The time (see fndts::os::Clock::now()).
+        **/
+        inline void setTimestamp(const fndts::os::tNanos t)
+        { header.timestamp = t; header.flags |= eMSGTIMESTAMP; }
+
+        /**
+         *  \brief  Sets the current time as the timestamp of the message.
+        **/
+        inline void stamp()
+        { setTimestamp(fndts::os::Clock::now()); }
+
+        /**
+         *  \brief  Gets the timestamp of the message.
+         *  \return The time; 0 if not set.
+        **/
+        inline const fndts::os::tNanos getTimestamp() const
+        { return header.timestamp; }
+
+        /**
+         *  \brief  Tells whether the timestamp is set.
+         *  \return true if set.
+        **/
+        inline const bool hasTimestamp() const
+        { return (header.flags & eMSGTIMESTAMP) != 0; }
+
+        /**
+         *  \brief  Gets the latency trace of the message (see Tracer).
+         *  \return The trace header; NULL if the message is not traced.
+        **/
+        inline tTraceHeader * getTrace() const
+        { return trace; }
+
+        /**
+         *  \brief  Sets a copy of the given latency trace to the message.
+         *  \param  h   The trace header; NULL to stop tracing the message.
+        **/
+        void setTrace(const tTraceHeader *h);
+
+        /**
+         *  \brief  Sets the time after which the message is useless.
+         *
+         *  Channels supporting it (see Queue) discard expired messages
+         *  instead of delivering them.
+         *
+         *  \param  d   The deadline (see fndts::os::Clock::now()); 0 for none.
+        **/
+        inline void setDeadline(const fndts::os::tNanos d)
+        { header.deadline = d; }
+
+        /**
+         *  \brief  Sets the deadline of the message relative to now.
+         *  \param  ttl Time to live in nanoseconds.
+        **/
+        inline void setTimeToLive(const fndts::os::tNanos ttl)
+        { header.deadline = fndts::os::Clock::now() + ttl; }
+
+        /**
+         *  \brief  Gets the deadline of the message.
+         *  \return The deadline; 0 if it never expires.
+        **/
+        inline const fndts::os::tNanos getDeadline() const
+        { return header.deadline; }
+
+        /**
+         *  \brief  Tells whether the message has expired at the given time.
+         *  \param  now The current time (see fndts::os::Clock::now()).
+         *  \return true if the message has a deadline and it has passed.
+        **/
+        inline const bool isExpired(const fndts::os::tNanos now) const
+        { return header.deadline != 0 && now >= header.deadline; }
+
+        /**
+         *  \brief  Tells whether the message has expired.
+         *  \return true if the message has a deadline and it has passed.
+        **/
+        inline const bool isExpired() const
+        { return header.deadline != 0 &&
+                 fndts::os::Clock::now() >= header.deadline; }
 };
 
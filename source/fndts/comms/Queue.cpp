@@ -26,45 +26,202 @@ fndts::os::MutexThread Queue::gmutex;
 /* -- Object methods -------------------------------------------------------- */
 
 // Public method: close
-// Closes the queue discarding pending messages.
+// Closes the queue discarding pending messages. Their counts are left behind
+// as stale, as for expired messages, and consumed by the receivers that find
+// the queue empty, so a count posted or taken meanwhile is not lost. Only
+// the places of the discarded messages are released: stale counts gave
+// theirs back when they were dropped.
 const bool Queue::close()
 {
     mutex.lock();
-    while (!q.empty())
-        q.pop();
+    size_t pending = q.size();
+    q.clear();
+    stale += pending;
     mutex.unlock();
+    release(pending);
     return true;
 }
 
 // Public method: send
-// Sends a message to the queue
+// Sends a message to the queue, waking up one waiting receiver. A bounded
+// queue waits for a free place first.
 const bool Queue::send (const Message &m) 
 {
-    msgavail.lock(); 
-    q.push(m);
-    msgavail.signal(); 
-    msgavail.unlock(); 
+    if (capacity > 0) room.wait();
+    push(m);
+    return true;
+}
+
+// Public method: trySend
+// Sends a message only if there is a free place
+const bool Queue::trySend (const Message &m) 
+{
+    if (capacity > 0 && !room.tryWait()) return false;
+    push(m);
     return true;
 }
 
 // Public method: receive
-// Waits for a message in the queue and copies it in the parameter
+// Waits for a message in the queue and copies it in the parameter. Expired
+// messages at the front are discarded; the counts they leave behind are
+// consumed by the receivers that find the queue empty, which wait again.
 const bool Queue::receive(comms::Message & r)
 {
-    /* When no message available, wait for one */
-    msgavail.lock(); 
-    if (q.empty())
+    unsigned long long n;
+    int got;
+    do
+    {
+        /* When no message available, wait for one */
+        waitFor(msgavail);
+        got = take(r, n);
+    }
+    while (got == 0);
+    return got > 0;
+}
+
+// Public method: receive
+// Like receive, but waiting for a limited time.
+const bool Queue::receive(comms::Message & r, const fndts::os::tNanos t)
+{
+    unsigned long long n;
+    return receive(r, t, n);
+}
+
+// Public method: receive
+// Like receive, but waiting for a limited time and giving the number of the
+// message.
+const bool Queue::receive(comms::Message & r, const fndts::os::tNanos t,
+                          unsigned long long & n)
+{
+    fndts::os::tNanos end = fndts::os::Clock::now() + t;
+    int got;
+    do
+    {
+        fndts::os::tNanos now = fndts::os::Clock::now();
+        if (now >= end || !msgavail.timedWait(end - now)) return false;
+        got = take(r, n);
+    }
+    while (got == 0);
+    return got > 0;
+}
+
+// Public method: tryReceive
+// Takes a message only if there is one
+const bool Queue::tryReceive(comms::Message & r)
+{
+    unsigned long long n;
+    return tryReceive(r, n);
+}
+
+// Public method: tryReceive
+// Takes a message only if there is one, giving its number
+const bool Queue::tryReceive(comms::Message & r, unsigned long long & n)
+{
+    int got;
+    do
+    {
+        if (!msgavail.tryWait()) return false;
+        got = take(r, n);
+    }
+    while (got == 0);
+    return got > 0;
+}
+
+// Public method: sweep
+// Discards the expired messages anywhere in the queue. Their counts are left
+// behind for the receivers.
+const size_t Queue::sweep()
+{
+    fndts::os::tNanos now = fndts::os::Clock::now();
+    size_t n = 0;
+    mutex.lock();
+    std::deque<Message>::iterator ite = q.begin();
+    while (ite != q.end())
     {
-        msgavail.wait();
+        if (ite->isExpired(now))
+        {
+            ite = q.erase(ite);
+            n++;
+        }
+        else
+            ite++;
     }
-    msgavail.unlock(); 
-         
-    /* Get the message */
+    stale += n;
+    mutex.unlock();
+    release(n);
+    countExpired(n);
+    return n;
+}
+
+// Public method: size
+// Returns the number of queued messages, expired or not
+const size_t Queue::size()
+{
     mutex.lock();
-    r = q.front();
-    q.pop();
+    size_t sz = q.size();
     mutex.unlock();
-    return true;
+    return sz;
+}
+
+// Private method: take
+// Gets the front message once its count has been taken, numbered in the
+// order messages leave the queue. Returns 1 when a message is got; 0 when
+// the count belonged to a discarded message, so that the caller waits again;
+// and -1 when the queue was closed.
+const int Queue::take(comms::Message & r, unsigned long long & n)
+{
+    mutex.lock();
+    size_t dropped = dropExpired();
+    if (!q.empty())
+    {
+        stale += dropped;
+        r = q.front();
+        q.pop_front();
+        n = taken++;
+        mutex.unlock();
+        release(dropped + 1);
+        traceDequeue(r);
+        return 1;
+    }
+    int got = 0;
+    if (dropped > 0)
+        stale += dropped - 1;
+    else if (stale > 0)
+        stale--;
+    else
+        got = -1;
+    mutex.unlock();
+    release(dropped);
+    return got;
+}
+
+// Private method: push
+// Appends the message, waking up one waiting receiver
+void Queue::push(const Message & m)
+{
+    mutex.lock();
+    q.push_back(m);
+    traceEnqueue(q.back());
+    mutex.unlock();
+    msgavail.post(1);
+}
+
+// Private method: dropExpired
+// Pops the expired messages at the front. The clock is only read when a
+// message with a deadline is found. The mutex must be locked.
+const size_t Queue::dropExpired()
+{
+    fndts::os::tNanos now = 0;
+    size_t n = 0;
+    while (!q.empty() && q.front().getDeadline() != 0)
+    {
+        if (now == 0) now = fndts::os::Clock::now();
+        if (!q.front().isExpired(now)) break;
+        q.pop_front();
+        n++;
+    }
+    if (n > 0) countExpired(n);
+    return n;
 }
 
 /* -- Class methods --------------------------------------------------------- */
@@ -96,13 +253,17 @@ Queue * Queue::getQueue(unsigned int n)
 /* -- Constructors ---------------------------------------------------------- */
 
 // Public constructor: Queue
-// Creates a system message queue
-Queue::Queue()
+// Creates a message queue, bounded when given a capacity
+Queue::Queue(const size_t c)
 :
     /* Attribute construction */
     id(0),
     q(),
+    stale(0),
+    taken(0),
+    capacity(c),
     msgavail(),
+    room(c),
     mutex(),
 
     /* Superclass construction */
@@ -18,8 +18,9 @@
 /* Include files */
 #include "Channel.h"
 #include "Message.h"
-#include "os/thread/CondThread.h"
-#include <queue>
+#include "os/thread/MutexThread.h"
+#include "os/thread/FutexThread.h"
+#include <deque>
 #include <map>
 
 /* Namespace definition and forward declarations */
@@ -29,7 +30,20 @@ namespace fndts { namespace comms { class Queue; } }
  *  \ingroup comms
  *  \brief   A message channel to communicate two Thread objects in the same
  *           execution environment using a FIFO queue of Message objects.
- *  \todo    Define Queue class.
+ *
+ *  Available messages are counted with a FutexThread: a receiver spins for a
+ *  short while and then parks, and each sent message wakes at most one
+ *  parked receiver. Receivers may wait otherwise (see
+ *  Channel::setWaitStrategy).
+ *
+ *  Messages with a deadline (see Message::setDeadline) which expired while
+ *  queued are not delivered: receivers discard them when they reach the
+ *  front of the queue, and sweep() discards them anywhere in the queue.
+ *  They are counted in Channel::getExpiredCount().
+ *
+ *  A queue may be bounded: then send() waits while the queue holds as many
+ *  messages as its capacity, pushing back on senders faster than the
+ *  receivers, and trySend() fails instead of waiting.
 **/
 class fndts::comms::Queue : public fndts::comms::Channel
 {
@@ -37,9 +51,13 @@ class fndts::comms::Queue : public fndts::comms::Channel
         static std::map<unsigned int,Queue*> qlist; /* All existing queues */
         static fndts::os::MutexThread gmutex;   /* Mutex for static members */
 
-        std::queue<Message> q;      /* The fifo queue to store the messages */
+        std::deque<Message> q;      /* The fifo queue to store the messages */
         int id;                     /* Queue identifier */
-        fndts::os::CondThread msgavail; /* Message available signal */
+        unsigned long stale;        /* Counts left by discarded messages */
+        unsigned long long taken;   /* Messages received so far */
+        size_t capacity;            /* Maximum messages queued; 0 unbounded */
+        fndts::os::FutexThread msgavail; /* Available messages count */
+        fndts::os::FutexThread room;    /* Free places when bounded */
         fndts::os::MutexThread mutex;   /* Mutex for object members */
 
         /* Copy constructor and assignment operator disabled */
@@ -47,11 +65,27 @@ class fndts::comms::Queue : public fndts::comms::Channel
         Queue(Queue & src):Channel("disabled") {}
         Queue & operator = (const Queue & src) {}
 
+        /* Gets the front message and its number once its count has been
+         * taken */
+        const int take(comms::Message & r, unsigned long long & n);
+
+        /* Discards the expired messages at the front of the queue */
+        const size_t dropExpired();
+
+        /* Appends a message once it has a place */
+        void push(const comms::Message & m);
+
+        /* Gives back the places of removed messages */
+        inline void release(const size_t n)
+        { if (capacity > 0 && n > 0) room.post(n); }
+
     public:
         /**
          *  \brief  Creates a queue.
+         *  \param  c   The maximum number of queued messages; 0 for an
+         *              unbounded queue.
         **/
-        Queue();
+        explicit Queue(const size_t c = 0);
 
         /**
          *  \brief  Destoys a queue.
@@ -76,6 +110,13 @@ class fndts::comms::Queue : public fndts::comms::Channel
         **/
         virtual const bool send(const comms::Message & m);
 
+        /**
+         *  \brief  Sends a Message only if the queue is not full.
+         *  \param  m   Message to send.
+         *  \return true if it was queued; false, otherwise.
+        **/
+        const bool trySend(const comms::Message & m);
+
         /**
          *  \brief  Receives a Message from this messenger.
          *  \param  r   The received message will be written here.
@@ -83,6 +124,69 @@ class fndts::comms::Queue : public fndts::comms::Channel
         **/
         virtual const bool receive (comms::Message & r);
 
+        /**
+         *  \brief  Receives a Message waiting for a limited time.
+         *
+         *  The wait strategy of the queue is not used: the receiver spins
+         *  and then parks until the time passes.
+         *
+         *  \param  r   The received message will be written here.
+         *  \param  t   Maximum time to wait in nanoseconds.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool receive (comms::Message & r, const fndts::os::tNanos t);
+
+        /**
+         *  \brief  Receives a Message only if there is one, without waiting.
+         *  \param  r   The received message will be written here.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool tryReceive (comms::Message & r);
+
+        /**
+         *  \brief  Receives a Message waiting for a limited time, with the
+         *          number of messages received from the queue before it.
+         *
+         *  Numbers are given in the order messages leave the queue, so that
+         *  several receivers can restore that order after working apart.
+         *
+         *  \param  r   The received message will be written here.
+         *  \param  t   Maximum time to wait in nanoseconds.
+         *  \param  n   The number of the message will be written here.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool receive (comms::Message & r, const fndts::os::tNanos t,
+                            unsigned long long & n);
+
+        /**
+         *  \brief  Receives a Message only if there is one, with its number
+         *          (see receive()).
+         *  \param  r   The received message will be written here.
+         *  \param  n   The number of the message will be written here.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool tryReceive (comms::Message & r, unsigned long long & n);
+
+        /**
+         *  \brief  Discards all the expired messages in the queue. Call it
+         *          from time to time to free the memory of a backlog.
+         *  \return The number of messages discarded.
+        **/
+        const size_t sweep();
+
+        /**
+         *  \brief  Gets the number of messages in the queue.
+         *  \return The number of messages.
+        **/
+        const size_t size();
+
+        /**
+         *  \brief  Gets the maximum number of queued messages.
+         *  \return The capacity; 0 when unbounded.
+        **/
+        inline const size_t getCapacity() const
+        { return capacity; }
+
         /**
          *  \brief  Gets the identifier of this Queue.
          *  \return The Id
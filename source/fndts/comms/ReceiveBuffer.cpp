@@ -0,0 +1,76 @@
+// Communications library (COMMS): ReceiveBuffer class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ReceiveBuffer.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ReceiveBuffer class implementation file.
+**/
+
+#include "ReceiveBuffer.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: reserve
+// Grows the storage when the asked payload size does not fit in it. The
+// storage is never shrunk, so it is reused by all later receptions.
+void ReceiveBuffer::reserve(const size_t sz)
+{
+    if (sz <= capacity) return;
+
+    delete []storage;
+    capacity = sz;
+    length = 0;
+    storage = new tByte[sizeof(long)+sizeof(tFragmentHeader)+capacity];
+    *reinterpret_cast<long *>(storage) = 0;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: ReceiveBuffer
+// Creates a buffer with the given initial capacity
+ReceiveBuffer::ReceiveBuffer(const size_t sz)
+:
+    /* Attribute construction */
+    storage(NULL),
+    capacity(sz),
+    length(0)
+{
+    storage = new tByte[sizeof(long)+sizeof(tFragmentHeader)+capacity];
+    *reinterpret_cast<long *>(storage) = 0;
+}
+
+// Private constructor: ReceiveBuffer
+// Copy constructor disabled being private
+ReceiveBuffer::ReceiveBuffer(const ReceiveBuffer & src)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~ReceiveBuffer
+// Deallocates the storage
+ReceiveBuffer::~ReceiveBuffer()
+{
+    delete []storage;
+}
+
+/* -- Operators ------------------------------------------------------------- */
+
+// Private operator: =
+// Assignment disabled being private
+ReceiveBuffer & ReceiveBuffer::operator = (const ReceiveBuffer & src)
+{
+    return *this;
+}
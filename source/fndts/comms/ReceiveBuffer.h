@@ -0,0 +1,136 @@
+// Foundations library (fndts): ReceiveBuffer class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ReceiveBuffer.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ReceiveBuffer class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <stddef.h>
+#include <stdint.h>
+#include "Message.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { 
+    class ReceiveBuffer; 
+    class SysQueue;
+
+    /**
+     *  \brief  The header SysQueue puts before the payload of every system
+     *          message, to split big messages in fragments and to carry the
+     *          header of the Message.
+    **/
+    struct tFragmentHeader
+    {
+        uint32_t sender;    /**< Process ID of the sender */
+        uint32_t id;        /**< Fragmented message ID (0 for a whole one) */
+        uint32_t total;     /**< Size of the whole message */
+        uint32_t offset;    /**< Offset of the fragment in the message */
+        tMessageHeader message; /**< Header of the message */
+    };
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A growable buffer, owned by the caller, where a SysQueue can
+ *           receive messages without allocating memory.
+ *
+ *  The buffer keeps its storage between receptions and only grows when a
+ *  received message does not fit in it (it never shrinks). Once the buffer
+ *  has reached the size of the biggest message of the traffic, receiving
+ *  does no allocation at all.
+ *
+ *  After a successful reception, the buffer acts as a view of the received
+ *  message: data() points to the payload and size() gives its length. The
+ *  view is valid until the next reception into the same buffer.
+ *
+ *  A %ReceiveBuffer is not shared: each consumer thread should own its own.
+ *
+ *  Example:
+ *  \code
+ *  ReceiveBuffer buf;
+ *  while (q.receive(buf,0))
+ *      process(buf.getType(), buf.data(), buf.size());
+ *  \endcode
+**/
+class fndts::comms::ReceiveBuffer
+{
+    private:
+        tByte   *storage;   /* The type (long), the header and the payload */
+        size_t  capacity;   /* Bytes available for the payload */
+        size_t  length;     /* Payload length of the last message received */
+
+        /* Copy constructor and assignment operator disabled */
+        ReceiveBuffer(const ReceiveBuffer & src);
+        ReceiveBuffer & operator = (const ReceiveBuffer & src);
+
+    public:
+        /**
+         *  \brief  Creates a receive buffer.
+         *  \param  sz  Initial capacity in bytes for the payload.
+        **/
+        explicit ReceiveBuffer(const size_t sz = 256);
+
+        /**
+         *  \brief  Deallocates the buffer.
+        **/
+        virtual ~ReceiveBuffer();
+
+        /**
+         *  \brief  Ensures the buffer can hold a payload of the given size.
+         *
+         *  The contents of the buffer are discarded if it needs to grow.
+         *
+         *  \param  sz  The payload size in bytes.
+        **/
+        void reserve(const size_t sz);
+
+        /**
+         *  \brief  Gets the type of the last received message.
+         *  \return The type of the message.
+        **/
+        inline const long getType() const
+        { return *reinterpret_cast<const long *>(storage); }
+
+        /**
+         *  \brief  Gets the header of the last received message.
+         *  \return The header, valid until the next reception.
+        **/
+        inline const tMessageHeader & getHeader() const
+        { return reinterpret_cast<const tFragmentHeader *>
+                     (storage + sizeof(long))->message; }
+
+        /**
+         *  \brief  Gets the payload of the last received message.
+         *  \return A pointer to the payload, valid until the next reception.
+        **/
+        inline const tByte * data() const
+        { return storage + sizeof(long) + sizeof(tFragmentHeader); }
+
+        /**
+         *  \brief  Gets the size in bytes of the last received message.
+         *  \return The size of the payload.
+        **/
+        inline const size_t size() const
+        { return length; }
+
+        /**
+         *  \brief  Gets the current capacity for the payload.
+         *  \return The capacity in bytes.
+        **/
+        inline const size_t getCapacity() const
+        { return capacity; }
+
+        /* Friend declarations. */
+        friend class SysQueue;
+};
@@ -0,0 +1,144 @@
+// Communications library (COMMS): Replayer class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Replayer.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Replayer class implementation file.
+**/
+
+#include <string.h>
+#include <time.h>
+#include "Replayer.h"
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/FutexThread.h"
+
+using namespace fndts::comms;
+using fndts::os::tNanos;
+using fndts::os::Clock;
+
+/* Waits shorter than this are spun instead of slept */
+#define REPLAY_SPIN     100000ULL
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: next
+// Reads a record header and its bytes
+const tByte * Replayer::next(tCaptureRecord & h)
+{
+    if (file == NULL) return NULL;
+    if (fread(&h, sizeof(h), 1, file) != 1) return NULL;
+    bytes.resize(h.length + 1);
+    if (h.length > 0 && fread(&bytes[0], 1, h.length, file) != h.length)
+        return NULL;
+    records++;
+    return &bytes[0];
+}
+
+// Public method: rewind
+// Goes back to the first record, after the file header
+void Replayer::rewind()
+{
+    if (file == NULL) return;
+    fseek(file, sizeof(tCaptureFileHeader), SEEK_SET);
+    records = 0;
+}
+
+// Public method: replay
+// Sends each record when its captured offset from the first one (scaled by
+// the speed) has passed since the replay started. The offset never goes
+// back: a record stamped before the latest one seen is sent right away.
+// Each message gets the captured header, with the time it had left before
+// its deadline counted from the moment it is sent. Received records are
+// skipped unless asked for.
+const unsigned long Replayer::replay(Channel & c, const bool paced,
+                                     const double speed, const bool received)
+{
+    tCaptureRecord h;
+    const tByte *p;
+    tNanos first = 0;
+    tNanos latest = 0;
+    tNanos start = Clock::now();
+    unsigned long sent = 0;
+    while ((p = next(h)) != NULL)
+    {
+        if (h.direction != eCAPTURESENT && !received) continue;
+        if (first == 0) first = latest = h.timestamp;
+        if (h.timestamp > latest) latest = h.timestamp;
+        if (paced && speed > 0)
+            waitUntil(start + (tNanos)((latest - first) / speed));
+
+        Message m;
+        if (h.length > 0) m.fromByteArray(h.length, p);
+        tMessageHeader mh = h.message;
+        if (mh.deadline != 0)
+        {
+            tNanos left = (mh.deadline > h.timestamp) ?
+                          mh.deadline - h.timestamp : 0;
+            mh.deadline = Clock::now() + left;
+        }
+        m.setHeader(mh);
+        if (c.send(m)) sent++;
+    }
+    return sent;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Private class method: waitUntil
+// Sleeps most of the wait and spins the rest, to be on time
+void Replayer::waitUntil(const tNanos t)
+{
+    tNanos now = Clock::now();
+    if (now >= t) return;
+    if (t - now > REPLAY_SPIN)
+    {
+        tNanos d = t - now - REPLAY_SPIN / 2;
+        struct timespec ts;
+        ts.tv_sec = d / 1000000000ULL;
+        ts.tv_nsec = d % 1000000000ULL;
+        nanosleep(&ts, NULL);
+    }
+    while (Clock::now() < t)
+        fndts::os::FutexThread::relax();
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Replayer
+// Opens the file and checks its header
+Replayer::Replayer(const std::string & path)
+:
+    /* Attribute construction */
+    file(NULL),
+    bytes(),
+    records(0)
+{
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL) return;
+
+    tCaptureFileHeader h;
+    if (fread(&h, sizeof(h), 1, file) != 1 ||
+        memcmp(h.magic, "FNDTSCAP", sizeof(h.magic)) != 0 || h.version != 2)
+    {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Replayer
+// Closes the file
+Replayer::~Replayer()
+{
+    if (file != NULL) fclose(file);
+}
@@ -0,0 +1,112 @@
+// Foundations library (fndts): Replayer class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Replayer.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Replayer class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "CaptureTap.h"
+#include "os/time/Clock.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class Replayer;
+    class Channel;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   Sends the messages of a capture file (see CaptureTap) to a
+ *           Channel.
+ *
+ *  Only the messages captured when sent are replayed, unless asked
+ *  otherwise: a message both sent and received through a tap is then
+ *  replayed once. Messages are sent in the captured order, either at their
+ *  original pace
+ *  (optionally sped up or slowed down) or as fast as possible, with the
+ *  header they were captured with. A deadline keeps the time it had left
+ *  when captured, counted from the moment the message is replayed.
+ *  Replaying the same file always produces the same message stream.
+**/
+class fndts::comms::Replayer
+{
+    private:
+        FILE *file;                 /* The capture file */
+        std::vector<tByte> bytes;   /* Bytes of the current record */
+        unsigned long records;      /* Records read */
+
+        /* Copy constructor and operator = disabled */
+        Replayer(const Replayer & src) {}
+        Replayer & operator = (const Replayer & src) { return *this; }
+
+        /* Waits until the given time */
+        static void waitUntil(const fndts::os::tNanos t);
+
+    public:
+        /**
+         *  \brief  Opens a capture file.
+         *  \param  path    The file.
+        **/
+        explicit Replayer(const std::string & path);
+
+        /**
+         *  \brief  Closes the capture file.
+        **/
+        virtual ~Replayer();
+
+        /**
+         *  \brief  Tells whether the file is an open capture file.
+         *  \return true if it can be replayed; false, otherwise.
+        **/
+        inline const bool isOpen() const
+        { return file != NULL; }
+
+        /**
+         *  \brief  Reads the next record of the file.
+         *  \param  h   The header of the record will be written here.
+         *  \return The message bytes, valid until the next call; NULL at
+         *          the end of the file.
+        **/
+        const tByte * next(tCaptureRecord & h);
+
+        /**
+         *  \brief  Goes back to the first record.
+        **/
+        void rewind();
+
+        /**
+         *  \brief  Sends the remaining records to a channel.
+         *  \param  c   The channel.
+         *  \param  paced   true to keep the captured intervals; false to
+         *                  send as fast as possible.
+         *  \param  speed   Speed factor applied to the captured intervals
+         *                  (2.0 replays twice as fast).
+         *  \param  received    true to send the records of received
+         *                      messages too; false to skip them.
+         *  \return The number of messages the channel accepted.
+        **/
+        const unsigned long replay(Channel & c, const bool paced = true,
+                                   const double speed = 1.0,
+                                   const bool received = false);
+
+        /**
+         *  \brief  Gets the number of records read.
+         *  \return The number of records.
+        **/
+        inline const unsigned long getRecordCount() const
+        { return records; }
+};
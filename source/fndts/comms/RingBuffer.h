@@ -0,0 +1,218 @@
+// Foundations library (fndts): RingBuffer class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   RingBuffer.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %RingBuffer class template header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Sequence.h"
+#include "SequenceBarrier.h"
+#include "os/thread/FutexThread.h"
+#include <vector>
+#include <sched.h>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { template <typename T> class RingBuffer; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A pre-allocated ring of entries shared by a producer and a chain
+ *           of processing stages.
+ *
+ *  The entries are allocated once and reused: the producer claims the next
+ *  entry with next(), fills it in place and makes it visible with publish().
+ *  Each stage (see RingStage) processes the entries in place once its
+ *  SequenceBarrier lets it, that is, once the producer and the stages it
+ *  depends on have passed them. Stages depending on the same upstream
+ *  stages run in parallel on the same entries. Nothing is copied nor queued
+ *  between stages.
+ *
+ *  The producer does not overwrite an entry until all the gating sequences
+ *  (those of the last stages) have passed it. There must be a single
+ *  producer thread.
+ *
+ *  The typical setup of A -> (B, C) -> D, where StageA to StageD are
+ *  subclasses of RingStage<tEntry> keeping its constructor, is:
+ *  \code
+ *      RingBuffer<tEntry> ring(1024);
+ *      StageA a("A", ring, ring.newBarrier());
+ *      StageB b("B", ring, ring.newBarrier(a.getSequence()));
+ *      StageC c("C", ring, ring.newBarrier(a.getSequence()));
+ *      std::vector<const Sequence *> bc;
+ *      bc.push_back(&b.getSequence()); bc.push_back(&c.getSequence());
+ *      StageD d("D", ring, ring.newBarrier(bc));
+ *      ring.addGatingSequence(d.getSequence());
+ *  \endcode
+ *
+ *  \param  T   The type of the entries. It must be default constructible.
+**/
+template <typename T>
+class fndts::comms::RingBuffer
+{
+    private:
+        std::vector<T> entries;                 /* The ring */
+        tSequence mask;                         /* Size of the ring - 1 */
+        Sequence cursor;                        /* Last published entry */
+        tSequence claimed;                      /* Last claimed entry */
+        tSequence gate;                         /* Cached minimum gating */
+        std::vector<const Sequence *> gating;   /* Sequences of last stages */
+        std::vector<SequenceBarrier *> barriers;/* Barriers of the stages */
+
+        /* Copy constructor and operator = disabled */
+        RingBuffer(const RingBuffer & src) {}
+        RingBuffer & operator = (const RingBuffer & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates a ring allocating all the entries.
+         *  \param  n   Minimum number of entries. It is rounded up to a power
+         *              of 2.
+        **/
+        explicit RingBuffer(const size_t n)
+        :
+            /* Attribute construction */
+            entries(),
+            mask(0),
+            cursor(),
+            claimed(Sequence::INITIAL),
+            gate(Sequence::INITIAL),
+            gating(),
+            barriers()
+        {
+            size_t sz = 1;
+            while (sz < n) sz <<= 1;
+            entries.resize(sz);
+            mask = sz - 1;
+        }
+
+        /**
+         *  \brief  Destroys the ring and the barriers created by it.
+        **/
+        virtual ~RingBuffer()
+        {
+            for (size_t i=0; i<barriers.size(); i++) delete barriers[i];
+        }
+
+        /**
+         *  \brief  Gets the number of entries.
+         *  \return The size of the ring.
+        **/
+        inline const size_t getSize() const
+        { return entries.size(); }
+
+        /**
+         *  \brief  Gets an entry.
+         *  \param  s   The sequence of the entry.
+         *  \return The entry.
+        **/
+        inline T & get(const tSequence s)
+        { return entries[s & mask]; }
+
+        /**
+         *  \brief  Gets the sequence of the last published entry.
+         *  \return The cursor.
+        **/
+        inline const Sequence & getCursor() const
+        { return cursor; }
+
+        /**
+         *  \brief  Adds a sequence the producer must not overtake. Add the
+         *          sequences of the last stages before publishing.
+         *  \param  s   The sequence.
+        **/
+        void addGatingSequence(const Sequence & s)
+        { gating.push_back(&s); }
+
+        /**
+         *  \brief  Claims the next entry, waiting while the ring is full.
+         *  \return The sequence of the claimed entry.
+        **/
+        const tSequence next()
+        {
+            tSequence s;
+            unsigned int i = 0;
+            while (!tryNext(s))
+            {
+                if (i++ < 1000)
+                    fndts::os::FutexThread::relax();
+                else
+                    sched_yield();
+            }
+            return s;
+        }
+
+        /**
+         *  \brief  Claims the next entry if the ring is not full.
+         *  \param  s   The sequence of the claimed entry will be written here.
+         *  \return true if the entry was claimed; false, otherwise.
+        **/
+        const bool tryNext(tSequence & s)
+        {
+            tSequence wrap = claimed + 1 - (mask + 1);
+            if (wrap > gate)
+            {
+                gate = SequenceBarrier::minimum(gating, claimed);
+                if (wrap > gate) return false;
+            }
+            s = ++claimed;
+            return true;
+        }
+
+        /**
+         *  \brief  Makes the claimed entries up to the given one visible to
+         *          the stages.
+         *  \param  s   The sequence of the last filled entry.
+        **/
+        inline void publish(const tSequence s)
+        { cursor.set(s); }
+
+        /**
+         *  \brief  Creates the barrier of a first stage.
+         *  \return The barrier, owned by the ring.
+        **/
+        SequenceBarrier & newBarrier()
+        {
+            return newBarrier(std::vector<const Sequence *>());
+        }
+
+        /**
+         *  \brief  Creates the barrier of a stage depending on another one.
+         *  \param  d   The sequence of the upstream stage.
+         *  \return The barrier, owned by the ring.
+        **/
+        SequenceBarrier & newBarrier(const Sequence & d)
+        {
+            return newBarrier(std::vector<const Sequence *>(1, &d));
+        }
+
+        /**
+         *  \brief  Creates the barrier of a stage depending on others.
+         *  \param  d   The sequences of the upstream stages.
+         *  \return The barrier, owned by the ring.
+        **/
+        SequenceBarrier & newBarrier(const std::vector<const Sequence *> & d)
+        {
+            SequenceBarrier *b = new SequenceBarrier(cursor, d);
+            barriers.push_back(b);
+            return *b;
+        }
+
+        /**
+         *  \brief  Alerts all the barriers, so that the stages stop.
+        **/
+        void alert()
+        {
+            for (size_t i=0; i<barriers.size(); i++) barriers[i]->alert();
+        }
+};
@@ -0,0 +1,122 @@
+// Foundations library (fndts): RingStage class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   RingStage.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %RingStage class template header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "RingBuffer.h"
+#include "Sequence.h"
+#include "SequenceBarrier.h"
+#include "os/thread/Thread.h"
+#include <string>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { template <typename T> class RingStage; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A thread processing in place the entries of a RingBuffer.
+ *
+ *  The stage waits on its barrier and processes every entry it lets it go
+ *  through, in order, with onEntry(). Its sequence is advanced once per
+ *  batch of available entries, so a stage falling behind catches up with
+ *  one barrier check for many entries. Downstream stages and the producer
+ *  wait on that sequence.
+ *
+ *  Launch the stage with launch(NULL); stop it with halt() and join().
+ *
+ *  \param  T   The type of the entries.
+**/
+template <typename T>
+class fndts::comms::RingStage : public fndts::os::Thread
+{
+    private:
+        RingBuffer<T> & ring;       /* The ring */
+        SequenceBarrier & barrier;  /* Where to wait for entries */
+        Sequence sequence;          /* Last processed entry */
+
+        /* Copy constructor and operator = disabled */
+        RingStage(const RingStage & src):Thread("disabled"),ring(src.ring),
+                                         barrier(src.barrier) {}
+        RingStage & operator = (const RingStage & src) { return *this; }
+
+    protected:
+        /**
+         *  \brief  Processes an entry.
+         *  \param  e   The entry, which may be modified in place.
+         *  \param  s   The sequence of the entry.
+         *  \param  last    true if it is the last entry available now.
+        **/
+        virtual void onEntry(T & e, const tSequence s, const bool last) = 0;
+
+        /**
+         *  \brief  The stage loop.
+         *  \param  arg Not used.
+         *  \return NULL
+        **/
+        virtual void * threadStartRoutine(void *arg)
+        {
+            tSequence next = sequence.get() + 1;
+            for (;;)
+            {
+                tSequence avail = barrier.waitFor(next);
+                if (avail < next) break;
+                for (; next <= avail; next++)
+                    onEntry(ring.get(next), next, next == avail);
+                sequence.set(avail);
+            }
+            return NULL;
+        }
+
+    public:
+        /**
+         *  \brief  Creates a stage.
+         *  \param  n   Name of the thread.
+         *  \param  r   The ring.
+         *  \param  b   The barrier of the stage (see RingBuffer::newBarrier).
+        **/
+        RingStage(const std::string & n, RingBuffer<T> & r, SequenceBarrier & b)
+        :
+            /* Attribute construction */
+            ring(r),
+            barrier(b),
+            sequence(),
+
+            /* Superclass construction */
+            Thread(n)
+        {
+        }
+
+        /**
+         *  \brief  Destroys the stage.
+        **/
+        virtual ~RingStage()
+        {
+        }
+
+        /**
+         *  \brief  Gets the sequence of the last processed entry.
+         *  \return The sequence.
+        **/
+        inline const Sequence & getSequence() const
+        { return sequence; }
+
+        /**
+         *  \brief  Makes the stage stop once it processed the entries
+         *          available.
+        **/
+        inline void halt()
+        { barrier.alert(); }
+};
@@ -0,0 +1,132 @@
+// Foundations library (fndts): SeqLock class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   SeqLock.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %SeqLock class template header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/thread/FutexThread.h"
+#include <string.h>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { template <typename T> class SeqLock; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   Publishes a small state snapshot from one writer to many readers,
+ *           none of them taking a lock.
+ *
+ *  The writer updates the value in place, making a sequence counter odd
+ *  while the copy is in progress and even again when it is done. Readers
+ *  copy the value and check that the counter was even and did not change
+ *  during their copy; otherwise, the copy may be torn and they retry.
+ *  Readers never write to shared memory, so any number of them can poll the
+ *  value at high frequency without disturbing each other nor the writer.
+ *
+ *  There must be a single writer at a time (serialize writers otherwise).
+ *  T is copied with memcpy, so it must be trivially copyable: this is
+ *  checked at compile time.
+ *
+ *  \param  T   The type of the published value.
+**/
+template <typename T>
+class fndts::comms::SeqLock
+{
+    private:
+        /* Compilation fails if T is not trivially copyable */
+        typedef char tTriviallyCopyable[__has_trivial_copy(T) ? 1 : -1];
+
+        volatile unsigned int seq;  /* Odd while the writer is copying */
+        char padding[64];
+        T value;                    /* The published value */
+
+        /* Copy constructor and assignment operator disabled */
+        SeqLock(const SeqLock & src) {}
+        SeqLock & operator = (const SeqLock & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates a %SeqLock publishing a zeroed value.
+        **/
+        SeqLock():seq(0)
+        { memset(&value, 0, sizeof(T)); }
+
+        /**
+         *  \brief  Creates a %SeqLock publishing the given value.
+         *  \param  v   The initial value.
+        **/
+        explicit SeqLock(const T & v):seq(0)
+        { memcpy(&value, &v, sizeof(T)); }
+
+        /**
+         *  \brief  Publishes a new value (writer only).
+         *  \param  v   The new value.
+        **/
+        void publish(const T & v)
+        {
+            seq = seq + 1;
+            __sync_synchronize();
+            memcpy(&value, &v, sizeof(T));
+            __sync_synchronize();
+            seq = seq + 1;
+        }
+
+        /**
+         *  \brief  Tries to copy the published value once.
+         *  \param  r   The value will be copied here. It may be torn when the
+         *              call fails.
+         *  \return true if the copy is consistent; false if the writer was
+         *          publishing at the same time.
+        **/
+        const bool tryRead(T & r) const
+        {
+            unsigned int s = seq;
+            if (s & 1) return false;
+            __sync_synchronize();
+            memcpy(&r, &value, sizeof(T));
+            __sync_synchronize();
+            return s == seq;
+        }
+
+        /**
+         *  \brief  Copies the published value, retrying torn reads.
+         *  \param  r   The value will be copied here.
+         *  \return The version of the copied value (see getVersion()).
+        **/
+        const unsigned int read(T & r) const
+        {
+            unsigned int s;
+            for (;;)
+            {
+                s = seq;
+                if ((s & 1) == 0)
+                {
+                    __sync_synchronize();
+                    memcpy(&r, &value, sizeof(T));
+                    __sync_synchronize();
+                    if (s == seq) return s >> 1;
+                }
+                fndts::os::FutexThread::relax();
+            }
+        }
+
+        /**
+         *  \brief  Gets the number of values published so far. Readers can
+         *          compare it with the one returned by read() to skip the
+         *          copy when nothing changed.
+         *  \return The current version.
+        **/
+        inline const unsigned int getVersion() const
+        { return seq >> 1; }
+};
@@ -0,0 +1,44 @@
+// Communications library (COMMS): Sequence class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Sequence.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Sequence class implementation file.
+**/
+
+#include "Sequence.h"
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+const tSequence Sequence::INITIAL;
+
+/* -- Object methods -------------------------------------------------------- */
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Sequence
+// Sets the initial value
+Sequence::Sequence(const tSequence v)
+:
+    /* Attribute construction */
+    value(v)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Sequence
+// Does nothing
+Sequence::~Sequence()
+{
+}
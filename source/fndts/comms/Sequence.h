@@ -0,0 +1,94 @@
+// Foundations library (fndts): Sequence class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Sequence.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Sequence class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class Sequence;
+
+    /**
+     *  \brief  A position in a RingBuffer. Entries are numbered from 0.
+    **/
+    typedef long long tSequence;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A counter telling how far a producer or a stage has gone in a
+ *           RingBuffer.
+ *
+ *  The value is alone in its cache lines, so a thread advancing its own
+ *  sequence does not slow down the threads reading the other ones. set()
+ *  makes all the writes done before it visible before the new value.
+**/
+class fndts::comms::Sequence
+{
+    private:
+        char padding0[64];
+        volatile tSequence value;   /* Last entry published or processed */
+        char padding1[64];
+
+        /* Copy constructor and operator = disabled */
+        Sequence(const Sequence & src) {}
+        Sequence & operator = (const Sequence & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Value of a sequence that has not passed any entry yet.
+        **/
+        static const tSequence INITIAL = -1;
+
+        /**
+         *  \brief  Creates a %Sequence.
+         *  \param  v   Initial value.
+        **/
+        explicit Sequence(const tSequence v = INITIAL);
+
+        /**
+         *  \brief  Destroys a %Sequence.
+        **/
+        virtual ~Sequence();
+
+        /**
+         *  \brief  Gets the value. Writes done before the matching set() are
+         *          visible after this call. x86 does not reorder loads, so
+         *          only the compiler is kept from moving reads before it
+         *          there; other processors get a full barrier.
+         *  \return The current value.
+        **/
+        inline const tSequence get() const
+        {
+            tSequence v = value;
+#if defined(__i386__) || defined(__x86_64__)
+            __asm__ __volatile__ ("" ::: "memory");
+#else
+            __sync_synchronize();
+#endif
+            return v;
+        }
+
+        /**
+         *  \brief  Sets the value after all the previous writes.
+         *  \param  v   The new value.
+        **/
+        inline void set(const tSequence v)
+        {
+            __sync_synchronize();
+            value = v;
+        }
+};
@@ -0,0 +1,106 @@
+// Communications library (COMMS): SequenceBarrier class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   SequenceBarrier.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %SequenceBarrier class implementation file.
+**/
+
+#include "SequenceBarrier.h"
+#include "os/thread/FutexThread.h"
+#include <sched.h>
+
+using namespace fndts::comms;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: waitFor
+// Polls the available entry, spinning first and then yielding the processor,
+// until it reaches the wanted one or the barrier is alerted.
+const tSequence SequenceBarrier::waitFor(const tSequence s) const
+{
+    tSequence avail;
+    unsigned int i = 0;
+    while ((avail = getAvailable()) < s)
+    {
+        if (alerted) return avail;
+        if (i < spins)
+        {
+            i++;
+            fndts::os::FutexThread::relax();
+        }
+        else
+            sched_yield();
+    }
+    return avail;
+}
+
+// Public method: getAvailable
+// The published entries not yet processed by the slowest upstream stage
+const tSequence SequenceBarrier::getAvailable() const
+{
+    return minimum(deps, cursor.get());
+}
+
+// Public method: alert
+// Waits give up
+void SequenceBarrier::alert()
+{
+    alerted = true;
+}
+
+// Public method: clearAlert
+// Waits work again
+void SequenceBarrier::clearAlert()
+{
+    alerted = false;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: minimum
+// Lowest value of the sequences or the default if there are none
+const tSequence SequenceBarrier::minimum(const std::vector<const Sequence *> & v,
+                                         const tSequence d)
+{
+    if (v.empty()) return d;
+    tSequence m = v[0]->get();
+    for (size_t i=1; i<v.size(); i++)
+    {
+        tSequence s = v[i]->get();
+        if (s < m) m = s;
+    }
+    return m;
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: SequenceBarrier
+// Keeps the cursor and the upstream sequences
+SequenceBarrier::SequenceBarrier(const Sequence & c,
+                                 const std::vector<const Sequence *> & d,
+                                 const unsigned int s)
+:
+    /* Attribute construction */
+    cursor(c),
+    deps(d),
+    spins(s),
+    alerted(false)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~SequenceBarrier
+// Does nothing
+SequenceBarrier::~SequenceBarrier()
+{
+}
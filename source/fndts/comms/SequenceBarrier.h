@@ -0,0 +1,106 @@
+// Foundations library (fndts): SequenceBarrier class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   SequenceBarrier.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %SequenceBarrier class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Sequence.h"
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class SequenceBarrier; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   Tells a stage of a RingBuffer up to which entry it may go.
+ *
+ *  A stage may process an entry once the producer has published it (the
+ *  cursor has passed it) and all the stages it depends on have processed
+ *  it. A barrier of a first stage has no dependencies.
+ *
+ *  Waiting stages spin for a while and then yield the processor. alert()
+ *  makes the waiting stages give up, to stop them.
+**/
+class fndts::comms::SequenceBarrier
+{
+    private:
+        const Sequence & cursor;                /* Published entries */
+        std::vector<const Sequence *> deps;     /* Upstream stages */
+        unsigned int spins;                     /* Polls before yielding */
+        volatile bool alerted;                  /* Waits must give up */
+
+        /* Copy constructor and operator = disabled */
+        SequenceBarrier(const SequenceBarrier & src):cursor(src.cursor) {}
+        SequenceBarrier & operator = (const SequenceBarrier & src)
+        { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates a barrier.
+         *  \param  c   The cursor of the producer.
+         *  \param  d   The sequences of the stages to wait for (may be
+         *              empty).
+         *  \param  s   Number of polls done before yielding the processor.
+        **/
+        SequenceBarrier(const Sequence & c,
+                        const std::vector<const Sequence *> & d,
+                        const unsigned int s = 1000);
+
+        /**
+         *  \brief  Destroys the barrier.
+        **/
+        virtual ~SequenceBarrier();
+
+        /**
+         *  \brief  Waits until the given entry may be processed.
+         *  \param  s   The entry.
+         *  \return The highest entry that may be processed, at least s; or
+         *          a lower value if the barrier was alerted.
+        **/
+        const tSequence waitFor(const tSequence s) const;
+
+        /**
+         *  \brief  Gets the highest entry that may be processed without
+         *          waiting.
+         *  \return The highest available entry.
+        **/
+        const tSequence getAvailable() const;
+
+        /**
+         *  \brief  Makes current and future waits give up.
+        **/
+        void alert();
+
+        /**
+         *  \brief  Lets waits work again after an alert().
+        **/
+        void clearAlert();
+
+        /**
+         *  \brief  Tells whether the barrier has been alerted.
+         *  \return true if alerted; false, otherwise.
+        **/
+        inline const bool isAlerted() const
+        { return alerted; }
+
+        /**
+         *  \brief  Gets the lowest value of a set of sequences.
+         *  \param  v   The sequences.
+         *  \param  d   The value returned if the set is empty.
+         *  \return The minimum value.
+        **/
+        static const tSequence minimum(const std::vector<const Sequence *> & v,
+                                       const tSequence d);
+};
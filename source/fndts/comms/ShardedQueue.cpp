@@ -0,0 +1,215 @@
+// Communications library (COMMS): ShardedQueue class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ShardedQueue.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ShardedQueue class implementation file.
+**/
+
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <limits.h>
+#include "ShardedQueue.h"
+#include "Message.h"
+#include "os/thread/FutexThread.h"
+
+using namespace fndts::comms;
+using fndts::os::FutexThread;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Discards the pending messages and wakes all the parked consumers.
+const bool ShardedQueue::close()
+{
+    closed = true;
+    for (unsigned int i=0; i<shards.size(); i++)
+    {
+        shards[i]->mutex.lock();
+        shards[i]->q.clear();
+        shards[i]->count = 0;
+        shards[i]->mutex.unlock();
+    }
+    __sync_fetch_and_add(&epoch, 1);
+    FutexThread::wake(&epoch, INT_MAX);
+    return true;
+}
+
+// Public method: send
+// Sends the message to the shard of the current CPU
+const bool ShardedQueue::send(const Message &m)
+{
+    return send(m, localShard());
+}
+
+// Public method: send
+// Pushes the message in the given shard. The parked consumers are checked
+// after a full barrier: either this producer sees a consumer registered as
+// sleeper, or that consumer sees the message in its last scan.
+const bool ShardedQueue::send(const Message &m, const unsigned int s)
+{
+    if (closed) return false;
+
+    tShard *shard = shards[s % shards.size()];
+    shard->mutex.lock();
+    shard->q.push_back(m);
+    traceEnqueue(shard->q.back());
+    shard->count = shard->q.size();
+    shard->mutex.unlock();
+
+    __sync_synchronize();
+    if (sleepers > 0)
+    {
+        __sync_fetch_and_add(&epoch, 1);
+        FutexThread::wake(&epoch, 1);
+    }
+    return true;
+}
+
+// Public method: receive
+// Scans the shards starting by the local one. When all of them are found
+// empty for a while, the consumer registers as sleeper, scans once more and
+// parks until a producer bumps the epoch.
+const bool ShardedQueue::receive(Message & r)
+{
+    unsigned int home = localShard();
+    unsigned int idle = 0;
+    while (!closed)
+    {
+        if (scan(home, r)) return true;
+
+        if (idle++ < spins)
+        {
+            FutexThread::relax();
+            continue;
+        }
+
+        int e = epoch;
+        __sync_fetch_and_add(&sleepers, 1);
+        bool found = scan(home, r);
+        if (!found && !closed) FutexThread::park(&epoch, e);
+        __sync_fetch_and_sub(&sleepers, 1);
+        if (found) return true;
+        idle = 0;
+    }
+    return false;
+}
+
+// Public method: tryReceive
+// Scans all the shards once
+const bool ShardedQueue::tryReceive(Message & r)
+{
+    if (closed) return false;
+    return scan(localShard(), r);
+}
+
+// Public method: size
+// Adds the pending messages hint of every shard
+const size_t ShardedQueue::size() const
+{
+    size_t sz = 0;
+    for (unsigned int i=0; i<shards.size(); i++)
+        sz += shards[i]->count;
+    return sz;
+}
+
+// Private method: localShard
+// The shard of the current CPU. If the CPU is not known, the thread identity
+// is used so that a thread keeps using the same shard.
+const unsigned int ShardedQueue::localShard() const
+{
+    int cpu = sched_getcpu();
+    if (cpu < 0) 
+        cpu = static_cast<int>(reinterpret_cast<unsigned long>(
+                  reinterpret_cast<void *>(pthread_self())) >> 12);
+    return static_cast<unsigned int>(cpu) % shards.size();
+}
+
+// Private method: take
+// Pops the first message of the shard. The count hint is checked before
+// taking the lock so that empty shards are skipped without writing to them.
+const bool ShardedQueue::take(const unsigned int s, Message & r)
+{
+    tShard *shard = shards[s];
+    if (shard->count == 0) return false;
+
+    shard->mutex.lock();
+    if (shard->q.empty())
+    {
+        shard->mutex.unlock();
+        return false;
+    }
+    r = shard->q.front();
+    shard->q.pop_front();
+    shard->count = shard->q.size();
+    shard->mutex.unlock();
+    traceDequeue(r);
+    return true;
+}
+
+// Private method: scan
+// Tries the home shard and then steals from the rest in order
+const bool ShardedQueue::scan(const unsigned int home, Message & r)
+{
+    if (take(home, r)) return true;
+    for (unsigned int i=1; i<shards.size(); i++)
+    {
+        if (take((home+i) % shards.size(), r))
+        {
+            __sync_fetch_and_add(&steals, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: ShardedQueue
+// Creates the shards: the given number or one per online CPU
+ShardedQueue::ShardedQueue(const unsigned int n, const unsigned int s)
+:
+    /* Attribute construction */
+    shards(),
+    spins(s),
+    epoch(0),
+    sleepers(0),
+    closed(false),
+    steals(0),
+
+    /* Superclass construction */
+    Channel("Sharded Queue")
+{
+    long nshards = n;
+    if (nshards == 0) nshards = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nshards <= 0) nshards = 1;
+
+    for (long i=0; i<nshards; i++)
+    {
+        tShard *shard = new tShard;
+        shard->count = 0;
+        shards.push_back(shard);
+    }
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~ShardedQueue
+// Closes the queue and destroys the shards
+ShardedQueue::~ShardedQueue()
+{
+    close();
+    for (unsigned int i=0; i<shards.size(); i++)
+        delete shards[i];
+}
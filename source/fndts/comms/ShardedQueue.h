@@ -0,0 +1,151 @@
+// Foundations library (fndts): ShardedQueue class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   ShardedQueue.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %ShardedQueue class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/MutexThread.h"
+#include <deque>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class ShardedQueue; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A message channel split in several sub-queues (shards) to scale
+ *           with many producers and consumers on many cores.
+ *
+ *  Each shard is a FIFO queue with its own mutex, kept in its own cache
+ *  lines. By default there is one shard per online CPU, and a producer sends
+ *  to the shard of the CPU it is running on, so producers on different cores
+ *  do not touch the same memory.
+ *
+ *  A consumer first looks in the shard of its own CPU and, when it is empty,
+ *  steals from the other shards. Messages are delivered in FIFO order within
+ *  a shard, but there is no global order between shards.
+ *
+ *  Idle consumers spin for a while and then park. Producers only write to
+ *  shared memory to wake them when some consumer is actually parked.
+**/
+class fndts::comms::ShardedQueue : public fndts::comms::Channel
+{
+    private:
+        /* A shard, padded so that two shards never share a cache line */
+        struct tShard
+        {
+            fndts::os::MutexThread mutex;   /* Mutex for the queue */
+            std::deque<Message> q;          /* The fifo queue */
+            volatile size_t count;          /* Pending messages (hint) */
+            char padding[64];
+        };
+
+        std::vector<tShard *> shards;   /* The sub-queues */
+        unsigned int spins;             /* Empty scans before parking */
+        volatile int epoch;             /* Futex word to park consumers */
+        volatile int sleepers;          /* Parked (or parking) consumers */
+        volatile bool closed;           /* The queue has been closed */
+        volatile unsigned long steals;  /* Messages taken from other shards */
+
+        /* Copy constructor and assignment operator disabled */
+        ShardedQueue(const ShardedQueue & src):Channel("disabled") {}
+        ShardedQueue & operator = (const ShardedQueue & src) { return *this; }
+
+        /* Gets the shard of the calling thread */
+        const unsigned int localShard() const;
+
+        /* Pops a message from the given shard if not empty */
+        const bool take(const unsigned int s, Message & r);
+
+        /* Takes a message from the local shard or steals it from others */
+        const bool scan(const unsigned int home, Message & r);
+
+    public:
+        /**
+         *  \brief  Creates a sharded queue.
+         *  \param  n   Number of shards (0 for one per online CPU).
+         *  \param  s   Empty scans done by a consumer before parking.
+        **/
+        explicit ShardedQueue(const unsigned int n = 0, 
+                              const unsigned int s = 100);
+
+        /**
+         *  \brief  Destroys a sharded queue.
+        **/
+        virtual ~ShardedQueue();
+
+        /**
+         *  \brief  Closes the queue discarding pending messages. Parked
+         *          consumers are woken and fail.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message to the shard of the caller's CPU.
+         *  \param  m   Message to send.
+         *  \return true if all OK; false if the queue is closed.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Sends a Message to the given shard.
+         *
+         *  Use it to keep the order of related messages sent from different
+         *  CPUs, or to group producers.
+         *
+         *  \param  m   Message to send.
+         *  \param  s   The shard (taken modulo the number of shards).
+         *  \return true if all OK; false if the queue is closed.
+        **/
+        const bool send(const comms::Message & m, const unsigned int s);
+
+        /**
+         *  \brief  Receives a Message, from the shard of the caller's CPU if
+         *          possible or from any other one otherwise.
+         *  \param  r   The received message will be written here.
+         *  \return true if everything ok; false if the queue is closed.
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Receives a Message only if there is one available.
+         *  \param  r   The received message will be written here.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool tryReceive (comms::Message & r);
+
+        /**
+         *  \brief  Gets the number of shards.
+         *  \return The number of shards.
+        **/
+        inline const unsigned int getShardCount() const
+        { return shards.size(); }
+
+        /**
+         *  \brief  Gets the number of messages received from a shard other
+         *          than the consumer's local one.
+         *  \return The number of stolen messages.
+        **/
+        inline const unsigned long getStealCount() const
+        { return steals; }
+
+        /**
+         *  \brief  Gets the approximate number of pending messages.
+         *  \return The number of messages in all the shards.
+        **/
+        const size_t size() const;
+};
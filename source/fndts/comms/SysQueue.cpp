@@ -14,15 +14,26 @@
 
 #include <sys/ipc.h> 
 #include <sys/msg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
 #include "SysQueue.h"
 #include "Message.h"
+#include "os/time/Clock.h"
 
 using namespace fndts::comms;
 
+/* Time given to a fragmented message to be complete, in nanoseconds */
+#define SYSQUEUE_MAXAGE     5000000000ULL
+
 /* -- Static member initialization ------------------------------------------ */
-const char* SysQueue::keyName="./keyfile"; 
-const char SysQueue::projectID='A';
+const char* SysQueue::defaultKeyName="./keyfile"; 
+const char SysQueue::defaultProjectID='A';
 const int SysQueue::permissions=0600;
+size_t SysQueue::maxMessageSize=0;
+volatile uint32_t SysQueue::fragmentID=0;
 
 /* -- Object methods -------------------------------------------------------- */
 
@@ -39,37 +50,68 @@ const bool SysQueue::close()
     return true;
 }
 
+// Public method: setSendType
+// Sets the type given to plain messages. System V does not allow sending
+// messages with a type lower than 1.
+const bool SysQueue::setSendType(const long t)
+{
+    if (t <= 0) return false;
+    sendtype = t;
+    return true;
+}
+
 // Public method: send
-// Sends a message to the queue
-const bool SysQueue::send (const Message &m) const
+// Sends a message to the queue with its type, or the default send type
+const bool SysQueue::send (const Message &m)
 {
-    /* Create a temporal SysQueueMessage of type 1 (0 not allowed when sending) */
-    tByte        array[m.size()];
-    SysQueueMessage tmsg(1l,m.size(),array);
+    long t = (m.getType() > 0) ? m.getType() : sendtype;
+    return send(t, m.getHeader(), m.size(), m.getData());
+}
 
-    /* Send a SysQueueMessage */
-    send(tmsg);
+// Public method: send
+// Sends a message to the queue with its type
+const bool SysQueue::send (const SysQueueMessage &m)
+{
+    return send(m.getType(), m.getHeader(), m.size(), m.getData());
 }
 
 // Public method: send
-// Sends a message to the queue
-const bool SysQueue::send (const SysQueueMessage &m) const
+// Sends the given bytes as a message of the given type
+const bool SysQueue::send (const long t, const size_t sz, const tByte *array)
 {
-    /** 
-     *  \todo   Check type of the message and throw an exception 
-     *  \todo   Error management.
-    **/
+    tMessageHeader mh = tMessageHeader();
+    mh.type = t;
+    return send(t, mh, sz, array);
+}
+
+// Private method: send
+// Sends the given bytes with the given type. When they do not fit in a
+// system message with the header, they are split in fragments sharing a new
+// fragmented message ID. Sending stops at the first failing fragment.
+const bool SysQueue::send (const long t, const tMessageHeader & mh,
+                           const size_t sz, const tByte *array)
+{
+    /* Type 0 or negative not allowed when sending */
+    if (t <= 0) return false;
 
-    /* Get the type and data of the message */
-    tByte contents[sizeof(long)+m.size()];
-    long * ptype = reinterpret_cast<long *>(contents);
-    *ptype++ = m.getType();
-    m.toByteArray( reinterpret_cast<tByte *>(ptype) );
+    tFragmentHeader h;
+    h.message = mh;
+    h.sender = getpid();
+    h.id = 0;
+    h.total = sz;
+    h.offset = 0;
 
-    /* Actually send the message */
-    msgsnd(id,contents,m.size(),0);
+    size_t chunk = getMaxPayloadSize();
+    if (sz <= chunk) return sendFragment(t, h, array, sz);
 
-    /** \todo   Check result of msgsnd and return true/false **/
+    do
+        h.id = __sync_add_and_fetch(&fragmentID, 1);
+    while (h.id == 0);
+    for (h.offset = 0; h.offset < sz; h.offset += chunk)
+    {
+        size_t n = (sz - h.offset < chunk) ? sz - h.offset : chunk;
+        if (!sendFragment(t, h, array + h.offset, n)) return false;
+    }
     return true;
 }
 
@@ -77,73 +119,331 @@ const bool SysQueue::send (const SysQueueMessage &m) const
 // Receives a message from the queue
 const bool SysQueue::receive(comms::Message & r)
 {
-    /* Create a temporal SysQueueMessage with type 0 (allow any type of message) */
-    tByte buffer[r.size()];
-    SysQueueMessage tmsg(0l,r.size(),buffer);
+    /* Receive in a temporal buffer with the default receive selector */
+    ReceiveBuffer buffer(r.size());
+    if (!receive(buffer, recvtype)) return false;
 
-    /* Receive a SysQueueMessage */
-    receive(tmsg);
+    /* Copy the received message to the parameter */
+    r.fromByteArray(buffer.size(),buffer.data());
+    r.setHeader(buffer.getHeader());
+    return true;
 }
 
-
 // Public method: receive
-// Receives a message from the queue
+// Receives a message from the queue using the type of the message as selector
 const bool SysQueue::receive(comms::SysQueueMessage & r)
 {
-    /** 
-     *  \todo   Treat different means of receiving a message: sync, async, 
-     *          with timeouts, etc 
-     *  \todo   Error management.
-    **/
-
-    /* Check not empty destination message */
-    if (r.size() == 0) return false;
-
-    /* Allocate locally buffer for the received message */
-    int sz = sizeof(long)+r.size();
-    tByte buffer[sz];
+    return receive(r, r.getType());
+}
 
-    /* Pointers to easily access type and data in the buffer */
-    long *pType = reinterpret_cast<long *>(buffer);
-    tByte *pData = buffer+sizeof(long);
+// Public method: receive
+// Receives a message from the queue
+const bool SysQueue::receive(comms::SysQueueMessage & r, const long t)
+{
+    /* Receive in a temporal buffer */
+    ReceiveBuffer buffer(r.size());
+    if (!receive(buffer, t)) return false;
 
-    /* Actually receive the message */
-    /** \todo   Check the flags (last parameter of msgrcv call now 0) **/
-    msgrcv(id,buffer,r.size(),r.getType(),0);
     /* 
      * Load the buffered message to the object.
-     * We use the type received from the queue in case the one stored in the
-     * object was 0 (meaning "i want to receive any kind of message"). 
+     * We use the type received from the queue as the one given may be a
+     * selector (0 or negative) and not the actual type of the message.
     */
-    r.setType(*pType);
-    r.fromByteArray(r.size(),pData);
+    r.fromByteArray(buffer.size(),buffer.data());
+    r.setHeader(buffer.getHeader());
+    r.setType(buffer.getType());
+    return true;
+}
+
+// Public method: receive
+// Receives a message from the queue directly in the storage of the buffer
+const bool SysQueue::receive(ReceiveBuffer & b, const long t)
+{
+    return receive(b, t, true);
+}
+
+// Public method: tryReceive
+// Receives a message from the queue in the buffer if there is one
+const bool SysQueue::tryReceive(ReceiveBuffer & b, const long t)
+{
+    return receive(b, t, false);
+}
+
+// Private method: receive
+// Receives a message directly in the storage of the buffer. When the message
+// does not fit, msgrcv fails with E2BIG leaving the message in the queue, so
+// the buffer is grown and the reception retried. Fragments are assembled
+// until a whole message is got. Without waiting, msgrcv fails with ENOMSG
+// when the queue has nothing of the type.
+const bool SysQueue::receive(ReceiveBuffer & b, const long t, const bool wait)
+{
+    while (true)
+    {
+        ssize_t rcvd = msgrcv(id, b.storage, 
+                              sizeof(tFragmentHeader) + b.capacity, t,
+                              wait ? 0 : IPC_NOWAIT);
+        if (rcvd < 0)
+        {
+            if (errno != E2BIG) return false;
+            b.reserve(b.capacity < 128 ? 256 : 2*b.capacity);
+            continue;
+        }
+        if (rcvd < (ssize_t)sizeof(tFragmentHeader))
+        {
+            mutex.lock();
+            malformed++;
+            mutex.unlock();
+            continue;
+        }
+
+        const tFragmentHeader *h = 
+            reinterpret_cast<const tFragmentHeader *>(b.storage + sizeof(long));
+        if (h->id == 0)
+        {
+            b.length = rcvd - sizeof(tFragmentHeader);
+            return true;
+        }
+        if (assemble(b, rcvd - sizeof(tFragmentHeader))) return true;
+    }
+}
+
+// Public method: getPendingCount
+// Returns the number of messages being assembled
+const size_t SysQueue::getPendingCount()
+{
+    mutex.lock();
+    size_t n = assemblies.size();
+    mutex.unlock();
+    return n;
+}
+
+// Public method: getExpiredCount
+// Returns the number of fragmented messages dropped incomplete
+const unsigned long SysQueue::getExpiredCount()
+{
+    mutex.lock();
+    unsigned long n = expired;
+    mutex.unlock();
+    return n;
+}
+
+// Public method: getMalformedCount
+// Returns the number of system messages too short for the header
+const unsigned long SysQueue::getMalformedCount()
+{
+    mutex.lock();
+    unsigned long n = malformed;
+    mutex.unlock();
+    return n;
+}
+
+// Private method: sendFragment
+// Puts the type, the header and the bytes together in the send buffer, which
+// only grows, and sends them. The buffer has its own mutex, as msgsnd waits
+// while the system queue is full and receptions must not wait for it.
+const bool SysQueue::sendFragment(const long t, const tFragmentHeader & h,
+                                  const tByte *array, const size_t sz)
+{
+    sendmutex.lock();
+    if (sendbuffer.size() < sizeof(long) + sizeof(h) + sz)
+        sendbuffer.resize(sizeof(long) + sizeof(h) + sz);
+    *reinterpret_cast<long *>(&sendbuffer[0]) = t;
+    memcpy(&sendbuffer[sizeof(long)], &h, sizeof(h));
+    if (sz > 0) memcpy(&sendbuffer[sizeof(long) + sizeof(h)], array, sz);
+    bool sent = (msgsnd(id, &sendbuffer[0], sizeof(h) + sz, 0) == 0);
+    sendmutex.unlock();
+    return sent;
+}
 
-    /** \todo   Check result of msgrcv and return true/false **/
+// Private method: assemble
+// Copies the fragment in the buffer to the storage of its message, allocated
+// with the whole message size when its first fragment arrives; the messages
+// too old to be complete are dropped then. When the last fragment arrives,
+// that storage is swapped into the buffer, so the whole message is not copied
+// again, unless the buffer is bigger: it is kept, as it never shrinks.
+const bool SysQueue::assemble(ReceiveBuffer & b, const size_t sz)
+{
+    const long type = *reinterpret_cast<const long *>(b.storage);
+    tFragmentHeader h;
+    memcpy(&h, b.storage + sizeof(long), sizeof(h));
+    if (h.offset > h.total || sz > h.total - h.offset) return false;
+
+    std::pair<uint32_t,uint32_t> k(h.sender, h.id);
+    mutex.lock();
+    std::map<std::pair<uint32_t,uint32_t>,tAssembly>::iterator ite = 
+        assemblies.find(k);
+    if (ite == assemblies.end())
+    {
+        tAssembly a;
+        a.started = fndts::os::Clock::now();
+        if (a.started > SYSQUEUE_MAXAGE) expire(a.started - SYSQUEUE_MAXAGE);
+        a.storage = new tByte[sizeof(long) + sizeof(h) + h.total];
+        a.received = 0;
+        ite = assemblies.insert(std::make_pair(k, a)).first;
+    }
+    tAssembly & a = ite->second;
+    memcpy(a.storage + sizeof(long) + sizeof(h) + h.offset, b.data(), sz);
+    a.received += sz;
+    if (a.received < h.total)
+    {
+        mutex.unlock();
+        return false;
+    }
+
+    /* Complete: the buffer takes the storage of the message */
+    tByte *done = a.storage;
+    assemblies.erase(ite);
+    mutex.unlock();
+
+    *reinterpret_cast<long *>(done) = type;
+    h.id = 0;
+    h.offset = 0;
+    memcpy(done + sizeof(long), &h, sizeof(h));
+    if (b.capacity > h.total)
+    {
+        memcpy(b.storage, done, sizeof(long) + sizeof(h) + h.total);
+        delete []done;
+    }
+    else
+    {
+        delete []b.storage;
+        b.storage = done;
+        b.capacity = h.total;
+    }
+    b.length = h.total;
     return true;
 }
 
+// Private method: expire
+// Frees the assemblies whose first fragment arrived before the given time
+void SysQueue::expire(const fndts::os::tNanos t)
+{
+    std::map<std::pair<uint32_t,uint32_t>,tAssembly>::iterator ite =
+        assemblies.begin();
+    while (ite != assemblies.end())
+    {
+        if (ite->second.started < t)
+        {
+            delete [](ite->second.storage);
+            assemblies.erase(ite++);
+            expired++;
+        }
+        else ite++;
+    }
+}
+
+// Private method: create
+// Creates the system queue (or attaches to it if already exists) for the key
+// obtained from the key file and project ID.
+void SysQueue::create()
+{
+    /* Creates the queue */
+    key = ftok(keyName.c_str(),projectID);
+    /** 
+     *  \todo   Error treatment when creating the message queue 
+     *  \todo   Configure queue parameters with msgctl
+    **/
+    id =  msgget(key, permissions | IPC_CREAT);
+}
+
 /* -- Class methods --------------------------------------------------------- */
 
+// Public class method: getMaxMessageSize
+// Reads the msgmax kernel parameter the first time. If it cannot be read,
+// the Linux default is assumed.
+const size_t SysQueue::getMaxMessageSize()
+{
+    if (maxMessageSize == 0)
+    {
+        size_t sz = 8192;
+        FILE *f = fopen("/proc/sys/kernel/msgmax", "r");
+        if (f != NULL)
+        {
+            unsigned long v;
+            if (fscanf(f, "%lu", &v) == 1 && v > 0) sz = v;
+            fclose(f);
+        }
+        maxMessageSize = sz;
+    }
+    return maxMessageSize;
+}
+
+// Public class method: getMaxPayloadSize
+// The system limit minus the header
+const size_t SysQueue::getMaxPayloadSize()
+{
+    return getMaxMessageSize() - sizeof(tFragmentHeader);
+}
+
 /* -- Constructors ---------------------------------------------------------- */
 
 // Public constructor: SysQueue
-// Creates a system message queue
+// Creates a system message queue with the default key file and project ID
 SysQueue::SysQueue()
 :
     /* Attribute construction */
+    keyName(defaultKeyName),
+    projectID(defaultProjectID),
     master(true),
+    sendtype(1l),
+    recvtype(0l),
+    assemblies(),
+    mutex(),
+    expired(0),
+    malformed(0),
+    sendbuffer(),
+    sendmutex(),
 
     /* Superclass construction */
     Channel("Message queue")
 {
-    /* Creates the queue */
-    key = ftok(keyName,projectID);
-    /** 
-     *  \todo   Error treatment when creating the message queue 
-     *  \todo   Configure queue parameters with msgctl
-    **/
-    id =  msgget(key, permissions | IPC_CREAT);
-    master=true;
+    create();
+}
+
+// Public constructor: SysQueue
+// Creates a system message queue with the given key file and project ID
+SysQueue::SysQueue(const char *path, const char proj)
+:
+    /* Attribute construction */
+    keyName(path),
+    projectID(proj),
+    master(true),
+    sendtype(1l),
+    recvtype(0l),
+    assemblies(),
+    mutex(),
+    expired(0),
+    malformed(0),
+    sendbuffer(),
+    sendmutex(),
+
+    /* Superclass construction */
+    Channel("Message queue")
+{
+    create();
+}
+
+// Public constructor: SysQueue
+// Creates a system message queue with the given key file and project ID
+SysQueue::SysQueue(const std::string & path, const char proj)
+:
+    /* Attribute construction */
+    keyName(path),
+    projectID(proj),
+    master(true),
+    sendtype(1l),
+    recvtype(0l),
+    assemblies(),
+    mutex(),
+    expired(0),
+    malformed(0),
+    sendbuffer(),
+    sendmutex(),
+
+    /* Superclass construction */
+    Channel("Message queue")
+{
+    create();
 }
 
 // Public constructor: SysQueue
@@ -151,8 +451,19 @@ SysQueue::SysQueue()
 SysQueue::SysQueue(int qid)
 :
     /* Attribute construction */
+    keyName(),
+    projectID(0),
+    key(0),
     id(qid),
     master(false),
+    sendtype(1l),
+    recvtype(0l),
+    assemblies(),
+    mutex(),
+    expired(0),
+    malformed(0),
+    sendbuffer(),
+    sendmutex(),
 
     /* Superclass construction */
     Channel("Message queue")
@@ -166,4 +477,7 @@ SysQueue::SysQueue(int qid)
 SysQueue::~SysQueue()
 {
     if (master) close();
+    std::map<std::pair<uint32_t,uint32_t>,tAssembly>::iterator ite;
+    for (ite = assemblies.begin(); ite != assemblies.end(); ite++)
+        delete [](ite->second.storage);
 }
@@ -17,9 +17,15 @@
 
 /* Include files */
 #include <sys/types.h> 
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <vector>
 #include "Channel.h"
 #include "Message.h"
 #include "SysQueueMessage.h"
+#include "ReceiveBuffer.h"
+#include "os/thread/MutexThread.h"
 
 /* Namespace definition and forward declarations */
 namespace fndts { namespace comms { class SysQueue; } }
@@ -28,23 +34,110 @@ namespace fndts { namespace comms { class SysQueue; } }
  *  \ingroup comms
  *  \brief   A message queue to communicate two Node objects in the same
  *           computer.
- *  \todo    Define SysQueue class.
+ *
+ *  The %SysQueue is built over a System V message queue. Every message in the
+ *  queue carries a type (a positive long) which can be used to route messages
+ *  to different consumers sharing the same queue. The type selector used when
+ *  receiving follows the msgrcv() rules:
+ *
+ *      - 0, the first message in the queue is received, whatever its type.
+ *      - greater than 0, the first message of exactly that type is received.
+ *      - lower than 0, the first message with the lowest type less than or
+ *        equal to the absolute value of the selector is received. This allows
+ *        a priority receive where lower types are served first.
+ *
+ *  Several processes may then drain the same queue, each one waiting only for
+ *  its own types (per-consumer or per-topic), without being woken up for
+ *  messages that are not for them.
+ *
+ *  Messages are sent with their type (see Message::getType()) as system
+ *  type, untyped ones with the default send type, and received with the
+ *  default receive selector of the %SysQueue (see setSendType() and
+ *  setReceiveType()). The header of the message travels with its payload.
+ *
+ *  Messages bigger than the system limit (msgmax) are split in fragments
+ *  and put together again when received. Every system message carries a
+ *  small header (see tFragmentHeader) telling the sender and the fragmented
+ *  message it belongs to, so fragments of several messages may be
+ *  interleaved with each other and with whole messages. A fragmented message
+ *  is assembled in a single buffer allocated with its whole size when the
+ *  first fragment arrives. All the fragments of a message must be received
+ *  by the same %SysQueue object: do not let several processes receive the
+ *  types used to send big messages. A message still incomplete five seconds
+ *  after its first fragment (e.g. its sender died) is dropped when another
+ *  fragmented message starts arriving (see getExpiredCount()).
+ *
+ *  The system key of the queue is obtained with ftok() from a key file path
+ *  and a project ID. Both can be given when creating the %SysQueue.
 **/
 class fndts::comms::SysQueue : public fndts::comms::Channel
 {
     private:
-        static const char *keyName;     /* File for ftok() call */
-        static const char projectID;    /* Project ID for ftok() call */
-        static const int permissions;   /* SysQueue permissions */
+        static const char *defaultKeyName;  /* Default file for ftok() */
+        static const char defaultProjectID; /* Default project ID for ftok() */
+        static const int permissions;       /* SysQueue permissions */
+        static size_t maxMessageSize;       /* System limit (msgmax) */
+        static volatile uint32_t fragmentID;/* Last fragmented message ID */
+        std::string keyName;    /* File for ftok() call */
+        char projectID;         /* Project ID for ftok() call */
         key_t key;  /* Message SysQueue system key for creation */
         int id;     /* Message SysQueue ID */
         bool master;    /* Indicates if this instance is the master of the q. */
+        long sendtype;  /* Type given to plain Message objects when sent */
+        long recvtype;  /* Type selector used to receive plain Messages */
+
+        /* A fragmented message being received */
+        struct tAssembly
+        {
+            tByte *storage;     /* Type, header and the whole payload */
+            size_t received;    /* Bytes of payload received */
+            fndts::os::tNanos started;  /* Arrival of the first fragment */
+        };
+        std::map<std::pair<uint32_t,uint32_t>,tAssembly> assemblies;
+        fndts::os::MutexThread mutex;   /* Mutex for the assemblies */
+        unsigned long expired;  /* Fragmented messages dropped incomplete */
+        unsigned long malformed;    /* Messages too short for the header */
+        std::vector<tByte> sendbuffer;  /* Type, header and bytes to send */
+        fndts::os::MutexThread sendmutex;   /* Mutex for the send buffer */
+
+        /* Creates or attaches to the system queue for the current key */
+        void create();
+
+        /* Sends bytes with the given system type and message header */
+        const bool send(const long t, const tMessageHeader & mh,
+                        const size_t sz, const tByte *array);
+
+        /* Sends a system message with the given header */
+        const bool sendFragment(const long t, const tFragmentHeader & h,
+                                const tByte *array, const size_t sz);
+
+        /* Receives a message in a buffer, waiting for it or not */
+        const bool receive(ReceiveBuffer & b, const long t, const bool wait);
+
+        /* Adds the fragment in the buffer to its message. Returns true and
+         * leaves the whole message in the buffer once complete. */
+        const bool assemble(ReceiveBuffer & b, const size_t sz);
+
+        /* Drops the assemblies started before the given time. The mutex
+         * must be locked. */
+        void expire(const fndts::os::tNanos t);
 
     public:
+        /**@{**/
         /**
          *  \brief  Creates a system message queue.
+         *
+         *  The system key is obtained from the given key file and project ID.
+         *  When not given, the file "./keyfile" and the project ID 'A' are
+         *  used. The key file must exist.
+         *
+         *  \param  path    The path of the key file for the ftok() call.
+         *  \param  proj    The project ID for the ftok() call.
         **/
         SysQueue();
+        SysQueue(const char *path, const char proj);
+        SysQueue(const std::string & path, const char proj);
+        /**@}**/
 
         /**
          *  \brief  Creates a new %SysQueue and attaches it to the given system
@@ -65,6 +158,50 @@ class fndts::comms::SysQueue : public fndts::comms::Channel
         inline const int getSystemID() const
         { return id; }
 
+        /**
+         *  \brief  Gets the path of the key file used to create this queue.
+         *  \return The key file path (empty if attached by system id).
+        **/
+        inline const std::string getKeyName() const
+        { return keyName; }
+
+        /**
+         *  \brief  Gets the project ID used to create this queue.
+         *  \return The project ID (0 if attached by system id).
+        **/
+        inline const char getProjectID() const
+        { return projectID; }
+
+        /**
+         *  \brief  Gets the type given to plain Message objects when sent.
+         *  \return The default send type.
+        **/
+        inline const long getSendType() const
+        { return sendtype; }
+
+        /**
+         *  \brief  Sets the type given to plain Message objects when sent.
+         *  \param  t   The new send type. Must be greater than 0.
+         *  \return true if the type was set; false if it was not valid.
+        **/
+        const bool setSendType(const long t);
+
+        /**
+         *  \brief  Gets the type selector used to receive plain Message 
+         *          objects.
+         *  \return The default receive type selector.
+        **/
+        inline const long getReceiveType() const
+        { return recvtype; }
+
+        /**
+         *  \brief  Sets the type selector used to receive plain Message 
+         *          objects.
+         *  \param  t   The new selector (0 any, >0 exact, <0 priority).
+        **/
+        inline void setReceiveType(const long t)
+        { recvtype = t; }
+
         /**
          *  \brief  Closes the %queue cancelling all pending %messages.
         **/
@@ -75,14 +212,24 @@ class fndts::comms::SysQueue : public fndts::comms::Channel
          *  \param  m   %Message to send.
          *  \return true if all OK; false, otherwise.
         **/
-        virtual const bool send(const fndts::comms::Message & m) const;
+        virtual const bool send(const fndts::comms::Message & m);
 
         /**
          *  \brief  Sends a %message to this queue.
          *  \param  m   %Message to send.
          *  \return true if all OK; false, otherwise.
         **/
-        virtual const bool send(const fndts::comms::SysQueueMessage & m) const;
+        virtual const bool send(const fndts::comms::SysQueueMessage & m);
+
+        /**
+         *  \brief  Sends an array of bytes as a %message of the given type,
+         *          split in fragments if needed.
+         *  \param  t       The type of the message. Must be greater than 0.
+         *  \param  sz      Size of the array.
+         *  \param  array   The data to send.
+         *  \return true if all OK; false, otherwise.
+        **/
+        const bool send(const long t, const size_t sz, const tByte *array);
 
         /**
          *  \brief  Receives a %message from this queue.
@@ -93,10 +240,88 @@ class fndts::comms::SysQueue : public fndts::comms::Channel
 
         /**
          *  \brief  Receives a %message of the given type from this queue.
+         *
+         *  The type of the given message is used as the type selector. Once
+         *  received, it is replaced with the actual type of the message.
+         *
          *  \param  r   The received message will be written here.
          *  \return true if everything ok; false, otherwise
         **/
         virtual const bool receive (fndts::comms::SysQueueMessage & r);
 
+        /**
+         *  \brief  Receives a %message selected by type from this queue.
+         *  \param  r   The received message will be written here.
+         *  \param  t   The type selector (0 any, >0 exact, <0 priority).
+         *  \return true if everything ok; false, otherwise
+        **/
+        virtual const bool receive (fndts::comms::SysQueueMessage & r, 
+                                    const long t);
+
+        /**
+         *  \brief  Receives a %message selected by type into a buffer owned
+         *          by the caller.
+         *
+         *  The message is received directly in the buffer storage, which is
+         *  grown when the message does not fit in it. Reusing the same
+         *  buffer for all the receptions avoids any memory allocation once
+         *  it has grown up to the biggest message size.
+         *
+         *  \param  b   The buffer where the message will be received.
+         *  \param  t   The type selector (0 any, >0 exact, <0 priority).
+         *  \return true if everything ok; false, otherwise
+        **/
+        const bool receive (fndts::comms::ReceiveBuffer & b, const long t);
+
+        /**
+         *  \brief  Receives a %message selected by type into a buffer owned
+         *          by the caller, only if there is one.
+         *
+         *  Like receive(), but without waiting: when no message of the type
+         *  is queued, or the rest of a fragmented message has not arrived
+         *  yet, it returns false at once. The fragments already received
+         *  are kept for the next call.
+         *
+         *  \param  b   The buffer where the message will be received.
+         *  \param  t   The type selector (0 any, >0 exact, <0 priority).
+         *  \return true if a whole message was received; false, otherwise
+        **/
+        const bool tryReceive (fndts::comms::ReceiveBuffer & b, const long t);
+
+        /**
+         *  \brief  Gets the biggest payload the system lets send in a
+         *          single message (the msgmax kernel parameter).
+         *  \return The maximum message size in bytes.
+        **/
+        static const size_t getMaxMessageSize();
+
+        /**
+         *  \brief  Gets the biggest payload sent in a single system message,
+         *          without fragmenting it.
+         *  \return The maximum payload size in bytes.
+        **/
+        static const size_t getMaxPayloadSize();
+
+        /**
+         *  \brief  Gets the number of fragmented messages partially received.
+         *  \return The number of messages being assembled.
+        **/
+        const size_t getPendingCount();
+
+        /**
+         *  \brief  Gets the number of fragmented messages dropped because
+         *          they were not complete in time.
+         *  \return The number of messages dropped.
+        **/
+        const unsigned long getExpiredCount();
+
+        /**
+         *  \brief  Gets the number of system messages discarded because
+         *          they were too short to hold the header, such as those
+         *          sent to the queue by other programs.
+         *  \return The number of messages discarded.
+        **/
+        const unsigned long getMalformedCount();
+
 };
 
@@ -29,9 +29,6 @@ using namespace fndts::comms;
 // Creates an empty queue message
 SysQueueMessage::SysQueueMessage()
 :
-    /* Attribute construction */
-    messagetype(0),
-
     /* Superclass construction */
     Message()
 {
@@ -41,24 +38,20 @@ SysQueueMessage::SysQueueMessage()
 // Creates a queue message with the given type
 SysQueueMessage::SysQueueMessage(const long type)
 :
-    /* Attribute construction */
-    messagetype(type),
-
     /* Superclass construction */
     Message()
 {
+    setType(type);
 }
 
 // Public constructor: SysQueueMessage
 // Creates a queue message with the given initial data
 SysQueueMessage::SysQueueMessage(const long type, const size_t sz, const tByte *array)
 :
-    /* Attribute construction */
-    messagetype(type),
-
     /* Superclass construction */
     Message(sz,array)
 {
+    setType(type);
 }
 
 /* -- Destructor ------------------------------------------------------------ */
@@ -25,12 +25,11 @@ namespace fndts { namespace comms { class SysQueueMessage; } }
  *  \ingroup comms
  *  \brief   A Message to be sent/received through a SysQueue.
  *
+ *  The type of the message (see Message::getType()) is used as the type of
+ *  the system message, which receivers may select on.
 **/
 class fndts::comms::SysQueueMessage : public fndts::comms::Message
 {
-    private:
-        long messagetype;    /* Identifier of the type of message */
-
     public:
 
         /**@{**/
@@ -49,18 +48,4 @@ class fndts::comms::SysQueueMessage : public fndts::comms::Message
          *  \brief  Destroys the message.
         **/
         virtual ~SysQueueMessage();
-
-        /**
-         *  \brief  Gets the type of message in queue context.
-         *  \return The type of the message.
-        **/
-        inline const long getType() const
-        { return messagetype; }
-
-        /**
-         *  \brief  Sets the type of message to this %SysQueueMessage.
-         *  \param  type    The new type of message.
-        **/
-        inline void setType(const long type)
-        { messagetype = type; }
 };
@@ -0,0 +1,356 @@
+// Communications library (COMMS): TimerQueue class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   TimerQueue.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %TimerQueue class implementation file.
+**/
+
+#include <time.h>
+#include <sstream>
+#include "TimerQueue.h"
+#include "Message.h"
+#include "os/thread/Thread.h"
+
+using namespace fndts::comms;
+
+/* Wheel geometry: LEVELS levels of SLOTS slots (SLOTS = 2^BITS) */
+#define TQ_BITS     8
+#define TQ_SLOTS    256
+#define TQ_LEVELS   4
+#define TQ_NIL      0xffffffffu
+
+/*
+ * The timer thread. It just runs the timer queue loop.
+*/
+class fndts::comms::__comms_TimerThread : public fndts::os::Thread
+{
+    private:   TimerQueue *tq;
+    protected: virtual void * threadStartRoutine (void *arg) 
+               { tq->run(); return NULL; }
+    public:    __comms_TimerThread(const std::string & n, TimerQueue *q)
+               : Thread(n), tq(q) { }
+};
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Discards all the pending messages and stops the timer thread.
+const bool TimerQueue::close()
+{
+    mutex.lock();
+    closed = true;
+    for (unsigned int s=0; s<slots.size(); s++)
+    {
+        unsigned int t = slots[s];
+        slots[s] = TQ_NIL;
+        while (t != TQ_NIL)
+        {
+            unsigned int next = pool[t].next;
+            release(t);
+            t = next;
+        }
+    }
+    pending = 0;
+    mutex.unlock();
+    work.post();
+    return true;
+}
+
+// Public method: send
+// Delivers the message to the target at once.
+const bool TimerQueue::send(const Message & m)
+{
+    return target.send(m);
+}
+
+// Public method: receive
+// Not supported: this is a send only channel.
+const bool TimerQueue::receive(Message & r)
+{
+    return false;
+}
+
+// Public method: schedule
+// Schedules the message for the tick following the given delay.
+const tTimerId TimerQueue::schedule(const Message & m, const unsigned long ms)
+{
+    struct timespec at;
+    clock_gettime(CLOCK_MONOTONIC, &at);
+    at.tv_sec += ms / 1000;
+    at.tv_nsec += (ms % 1000) * 1000000L;
+    if (at.tv_nsec >= 1000000000L)
+    {
+        at.tv_sec++;
+        at.tv_nsec -= 1000000000L;
+    }
+    return scheduleAt(m, at);
+}
+
+// Public method: scheduleAt
+// Takes an entry from the pool and links it in the wheel. The timer thread
+// is woken up if the wheel was empty.
+const tTimerId TimerQueue::scheduleAt(const Message & m, 
+                                      const struct timespec & at)
+{
+    /* Tick of the delivery time, rounded up */
+    long long ns = (at.tv_sec - base.tv_sec) * 1000000000LL + 
+                   (at.tv_nsec - base.tv_nsec);
+    unsigned long long tick = ns <= 0 ? 0 : (ns + tickns - 1) / tickns;
+
+    mutex.lock();
+    if (closed)
+    {
+        mutex.unlock();
+        return 0;
+    }
+
+    /* An empty wheel has nothing to cascade: just catch up with the time */
+    bool wasidle = (pending == 0);
+    if (wasidle) current = now();
+    if (tick <= current) tick = current + 1;
+
+    /* Take an entry */
+    unsigned int t;
+    if (freelist != TQ_NIL)
+    {
+        t = freelist;
+        freelist = pool[t].next;
+    }
+    else
+    {
+        pool.push_back(tTimer());
+        t = pool.size() - 1;
+        pool[t].generation = 0;
+    }
+    pool[t].msg = m;
+    pool[t].expires = tick;
+    insert(t);
+    pending++;
+    tTimerId id = (static_cast<tTimerId>(pool[t].generation) << 32) | (t+1);
+    mutex.unlock();
+
+    if (wasidle) work.post();
+    return id;
+}
+
+// Public method: cancel
+// Unlinks the entry if it is still pending and belongs to the same use.
+const bool TimerQueue::cancel(const tTimerId id)
+{
+    unsigned int t = static_cast<unsigned int>(id & 0xffffffffu) - 1;
+    unsigned int g = static_cast<unsigned int>(id >> 32);
+    bool done = false;
+
+    mutex.lock();
+    if (id != 0 && t < pool.size() && pool[t].pending && 
+        pool[t].generation == g)
+    {
+        unlink(t);
+        release(t);
+        pending--;
+        done = true;
+    }
+    mutex.unlock();
+    return done;
+}
+
+// Public method: size
+// Returns the number of pending messages
+const size_t TimerQueue::size()
+{
+    mutex.lock();
+    size_t sz = pending;
+    mutex.unlock();
+    return sz;
+}
+
+// Private method: now
+// Returns the tick of the current time
+const unsigned long long TimerQueue::now() const
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    long long ns = (ts.tv_sec - base.tv_sec) * 1000000000LL + 
+                   (ts.tv_nsec - base.tv_nsec);
+    return ns <= 0 ? 0 : ns / tickns;
+}
+
+// Private method: insert
+// Links the entry at the head of the slot for its expiry tick. The level is
+// chosen by the distance to the current tick, so that the slot is cascaded
+// (or expired, for the first level) before the entry is due. Entries too far
+// in the future go to the farthest slot of the last level and are placed 
+// again each time it is cascaded.
+void TimerQueue::insert(const unsigned int t)
+{
+    tTimer & e = pool[t];
+    unsigned long long exp = e.expires < current ? current : e.expires;
+    unsigned long long delta = exp - current;
+
+    unsigned int level = 0;
+    while (level < TQ_LEVELS-1 && delta >= (1ULL << (TQ_BITS*(level+1))))
+        level++;
+    if (delta >= (1ULL << (TQ_BITS*TQ_LEVELS)))
+        exp = current + (1ULL << (TQ_BITS*TQ_LEVELS)) - 1;
+    unsigned int s = level*TQ_SLOTS + ((exp >> (TQ_BITS*level)) & (TQ_SLOTS-1));
+
+    e.slot = s;
+    e.prev = TQ_NIL;
+    e.next = slots[s];
+    if (e.next != TQ_NIL) pool[e.next].prev = t;
+    slots[s] = t;
+    e.pending = true;
+}
+
+// Private method: unlink
+// Removes the entry from its slot list
+void TimerQueue::unlink(const unsigned int t)
+{
+    tTimer & e = pool[t];
+    if (e.prev != TQ_NIL) pool[e.prev].next = e.next;
+    else                  slots[e.slot] = e.next;
+    if (e.next != TQ_NIL) pool[e.next].prev = e.prev;
+    e.pending = false;
+}
+
+// Private method: release
+// Puts the entry in the free list. The generation changes so that the old
+// identifier cannot cancel a later use of the entry.
+void TimerQueue::release(const unsigned int t)
+{
+    tTimer & e = pool[t];
+    e.msg = Message();
+    e.pending = false;
+    e.generation++;
+    e.next = freelist;
+    freelist = t;
+}
+
+// Private method: advance
+// Moves to the next tick. When the first level wraps, the slot of the next
+// level for the new tick is cascaded (placed again, now in lower levels), and
+// so on up the levels. Then the entries of the first level slot are due.
+void TimerQueue::advance(std::vector<Message> & due)
+{
+    current++;
+
+    for (unsigned int level=1; level<TQ_LEVELS; level++)
+    {
+        if ((current & ((1ULL << (TQ_BITS*level)) - 1)) != 0) break;
+
+        unsigned int s = level*TQ_SLOTS + 
+                         ((current >> (TQ_BITS*level)) & (TQ_SLOTS-1));
+        unsigned int t = slots[s];
+        slots[s] = TQ_NIL;
+        while (t != TQ_NIL)
+        {
+            unsigned int next = pool[t].next;
+            insert(t);
+            t = next;
+        }
+    }
+
+    unsigned int s = current & (TQ_SLOTS-1);
+    unsigned int t = slots[s];
+    slots[s] = TQ_NIL;
+    while (t != TQ_NIL)
+    {
+        unsigned int next = pool[t].next;
+        due.push_back(pool[t].msg);
+        release(t);
+        pending--;
+        t = next;
+    }
+}
+
+// Private method: run
+// Loop of the timer thread. It sleeps while the wheel is empty; otherwise it
+// advances the wheel up to the current tick, sends the due messages out of
+// the lock, and sleeps for one tick.
+void TimerQueue::run()
+{
+    std::vector<Message> due;
+    struct timespec tick;
+    tick.tv_sec = tickns / 1000000000LL;
+    tick.tv_nsec = tickns % 1000000000LL;
+
+    while (true)
+    {
+        mutex.lock();
+        if (closed)
+        {
+            mutex.unlock();
+            break;
+        }
+        if (pending == 0)
+        {
+            mutex.unlock();
+            work.wait();
+            continue;
+        }
+        unsigned long long n = now();
+        while (current < n && pending > 0)
+            advance(due);
+        mutex.unlock();
+
+        std::vector<Message>::const_iterator ite;
+        for (ite=due.begin(); ite!=due.end(); ite++)
+            target.send(*ite);
+        due.clear();
+
+        nanosleep(&tick, NULL);
+    }
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: TimerQueue
+// Creates an empty wheel starting now and launches the timer thread.
+TimerQueue::TimerQueue(Channel & t, const unsigned int ms)
+:
+    /* Attribute construction */
+    target(t),
+    tickns((ms > 0 ? ms : 1) * 1000000LL),
+    current(0),
+    pool(),
+    freelist(TQ_NIL),
+    slots(TQ_LEVELS*TQ_SLOTS, TQ_NIL),
+    pending(0),
+    closed(false),
+    mutex(),
+    work(0, 0),
+    timer(NULL),
+
+    /* Superclass construction */
+    Channel("Timer Queue")
+{
+    static int instances = 0;
+    std::ostringstream tname;
+    tname << "TimerQueue " << __sync_fetch_and_add(&instances, 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &base);
+    timer = new __comms_TimerThread(tname.str(), this);
+    timer->launch(NULL);
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~TimerQueue
+// Discards the pending messages and waits for the timer thread to finish.
+TimerQueue::~TimerQueue()
+{
+    close();
+    timer->join();
+    delete timer;
+}
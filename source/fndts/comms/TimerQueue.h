@@ -0,0 +1,192 @@
+// Foundations library (fndts): TimerQueue class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   TimerQueue.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %TimerQueue class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <time.h>
+#include <deque>
+#include <vector>
+#include "Channel.h"
+#include "Message.h"
+#include "os/thread/Thread.h"
+#include "os/thread/MutexThread.h"
+#include "os/thread/FutexThread.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { 
+    class TimerQueue; 
+    class __comms_TimerThread;
+
+    /**
+     *  \brief  Identifier of a scheduled message, used to cancel it. 
+     *          0 is never a valid identifier.
+    **/
+    typedef unsigned long long tTimerId;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   A channel which delivers messages to another Channel after a
+ *           delay or at a given time.
+ *
+ *  Scheduled messages are kept in a hierarchical timer wheel: four levels of
+ *  256 slots, the first one with one slot per tick and each next one with
+ *  slots 256 times wider. Scheduling and cancelling a message are O(1), and
+ *  a message goes down one level each time its slot is reached, until it is
+ *  due. The entries are kept in a pool reused by later messages, so there is
+ *  no thread nor heap node per pending message.
+ *
+ *  A single timer thread advances the wheel every tick and sends the due
+ *  messages of a tick, as a batch, to the target Channel. It sleeps when
+ *  there are no pending messages, and ends when the queue is closed: a
+ *  closed %TimerQueue does not schedule messages any more.
+ *
+ *  Sending a message with send() delivers it to the target at once. This
+ *  channel cannot be used to receive: receive() always fails.
+ *
+ *  Example:
+ *  \code
+ *  Queue work;
+ *  TimerQueue timers(work);
+ *  tTimerId t = timers.schedule(retry, 500);   // delivered in 500 ms
+ *  timers.cancel(t);                           // unless cancelled
+ *  \endcode
+**/
+class fndts::comms::TimerQueue : public fndts::comms::Channel
+{
+    private:
+        /* An entry of the wheel: a pending message in a slot list */
+        struct tTimer
+        {
+            Message msg;            /* Message to deliver */
+            unsigned long long expires; /* Tick when it is due */
+            unsigned int next;      /* Next entry in the slot (or free) list */
+            unsigned int prev;      /* Previous entry in the slot list */
+            unsigned int generation;/* Incremented each time it is reused */
+            unsigned short slot;    /* Level * 256 + slot in the level */
+            bool pending;           /* In a slot list */
+        };
+
+        Channel & target;                   /* Channel receiving the messages */
+        long long tickns;                   /* Tick length in nanoseconds */
+        struct timespec base;               /* Time of tick 0 */
+        unsigned long long current;         /* Last tick processed */
+        std::deque<tTimer> pool;            /* All the entries */
+        unsigned int freelist;              /* First free entry */
+        std::vector<unsigned int> slots;    /* Heads of the slot lists */
+        size_t pending;                     /* Scheduled messages */
+        bool closed;                        /* Timer thread must finish */
+        fndts::os::MutexThread mutex;       /* Mutex for the wheel */
+        fndts::os::FutexThread work;        /* Wakes the idle timer thread */
+        fndts::os::Thread *timer;           /* The timer thread */
+
+        /* Copy constructor and assignment operator disabled */
+        TimerQueue(const TimerQueue & src)
+        :Channel("disabled"),target(src.target) {}
+        TimerQueue & operator = (const TimerQueue & src) { return *this; }
+
+        /* Gets the tick of the current time */
+        const unsigned long long now() const;
+
+        /* Links an entry in the slot for its expiry tick. Locked. */
+        void insert(const unsigned int t);
+
+        /* Unlinks an entry from its slot. Locked. */
+        void unlink(const unsigned int t);
+
+        /* Returns an entry to the free list. Locked. */
+        void release(const unsigned int t);
+
+        /* Advances the wheel one tick, collecting due messages. Locked. */
+        void advance(std::vector<Message> & due);
+
+        /* Loop of the timer thread */
+        void run();
+
+        /* Friend declarations */
+        friend class __comms_TimerThread;
+
+    public:
+        /**
+         *  \brief  Creates a timer queue and launches its thread.
+         *  \param  t   The Channel where due messages are sent to.
+         *  \param  ms  Length of a tick in milliseconds (the resolution).
+        **/
+        explicit TimerQueue(Channel & t, const unsigned int ms = 1);
+
+        /**
+         *  \brief  Stops the timer thread and destroys the queue. Pending
+         *          messages are discarded.
+        **/
+        virtual ~TimerQueue();
+
+        /**
+         *  \brief  Discards all the pending messages and stops the timer
+         *          thread for good.
+         *
+         *  The queue cannot be used again: later schedules return 0. Send
+         *  still delivers to the target at once.
+         *
+         *  \return true.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message to the target channel at once.
+         *  \param  m   Message to send.
+         *  \return The result of the target's send().
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Not supported: messages are received from the target.
+         *  \param  r   Unused.
+         *  \return false.
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Schedules a Message to be sent to the target after a delay.
+         *  \param  m   Message to send.
+         *  \param  ms  Delay in milliseconds.
+         *  \return The identifier to cancel it; 0 if the queue is closed.
+        **/
+        const tTimerId schedule(const comms::Message & m, 
+                                const unsigned long ms);
+
+        /**
+         *  \brief  Schedules a Message to be sent to the target at a given
+         *          time of the CLOCK_MONOTONIC clock.
+         *  \param  m   Message to send.
+         *  \param  at  The delivery time. A past time delivers at next tick.
+         *  \return The identifier to cancel it; 0 if the queue is closed.
+        **/
+        const tTimerId scheduleAt(const comms::Message & m, 
+                                  const struct timespec & at);
+
+        /**
+         *  \brief  Cancels a scheduled Message not delivered yet.
+         *  \param  id  The identifier returned when it was scheduled.
+         *  \return true if cancelled; false if unknown or already delivered.
+        **/
+        const bool cancel(const tTimerId id);
+
+        /**
+         *  \brief  Gets the number of scheduled messages not delivered yet.
+         *  \return The number of pending messages.
+        **/
+        const size_t size();
+};
@@ -0,0 +1,190 @@
+// Communications library (COMMS): Topic class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Topic.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Topic class implementation file.
+**/
+
+#include "Topic.h"
+#include "Message.h"
+#include "Filter.h"
+
+using namespace fndts::comms;
+
+/* Subscribers picked at a time by a publisher */
+#define TOPIC_BATCH     16
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: close
+// Removes all the subscribers, once no publisher is sending to them
+const bool Topic::close()
+{
+    mutex.lock();
+    std::vector<tSubscription*> gone;
+    gone.swap(subs);
+    for (size_t i=0; i<gone.size(); i++) retire(gone[i]);
+    mutex.unlock();
+    return true;
+}
+
+// Public method: send
+// Evaluates the filters and sends the message to the accepting subscribers.
+// The targets are picked under the mutex, up to TOPIC_BATCH at a time, and
+// pinned while they are sent to with the mutex released. The next batch is
+// looked for after the last subscriber seen, by id, as the list may change
+// meanwhile.
+const bool Topic::send(const Message & m)
+{
+    tSubscription *targets[TOPIC_BATCH];
+    long t = m.getType();
+    unsigned long wanted = 0, sent = 0, skipped = 0;
+    unsigned int from = 0;
+    bool more = true;
+    while (more)
+    {
+        size_t n = 0;
+        mutex.lock();
+        size_t i = find(from);
+        for (; i<subs.size() && n<TOPIC_BATCH; i++)
+        {
+            if (!subs[i]->filter.matches(m, t))
+            {
+                skipped++;
+                continue;
+            }
+            subs[i]->busy++;
+            targets[n++] = subs[i];
+        }
+        more = (i < subs.size());
+        if (more) from = subs[i]->id;
+        mutex.unlock();
+        if (n == 0) continue;
+
+        for (size_t k=0; k<n; k++)
+            if (targets[k]->target->send(m)) sent++;
+        wanted += n;
+
+        mutex.lock();
+        for (size_t k=0; k<n; k++) targets[k]->busy--;
+        mutex.signal();
+        mutex.unlock();
+    }
+    __sync_fetch_and_add(&delivered, sent);
+    __sync_fetch_and_add(&filtered, skipped);
+    if (sent < wanted) __sync_fetch_and_add(&failed, wanted - sent);
+    return sent == wanted;
+}
+
+// Public method: receive
+// A topic cannot be received from
+const bool Topic::receive(Message & r)
+{
+    return false;
+}
+
+// Public method: subscribe
+// Adds the subscriber at the end of the list, which stays sorted by id
+const unsigned int Topic::subscribe(Channel & c, const Filter & f)
+{
+    tSubscription *s = new tSubscription;
+    s->target = &c;
+    s->filter = f;
+    s->busy = 0;
+    mutex.lock();
+    s->id = nextid++;
+    subs.push_back(s);
+    mutex.unlock();
+    return s->id;
+}
+
+// Public method: unsubscribe
+// Removes the subscriber with the given identifier, once no publisher is
+// sending to it
+const bool Topic::unsubscribe(const unsigned int id)
+{
+    bool found = false;
+    mutex.lock();
+    size_t i = find(id);
+    if (i < subs.size() && subs[i]->id == id)
+    {
+        tSubscription *s = subs[i];
+        subs.erase(subs.begin() + i);
+        retire(s);
+        found = true;
+    }
+    mutex.unlock();
+    return found;
+}
+
+// Public method: getSubscriberCount
+// Returns the number of subscribers
+const size_t Topic::getSubscriberCount()
+{
+    mutex.lock();
+    size_t n = subs.size();
+    mutex.unlock();
+    return n;
+}
+
+// Private method: find
+// Binary search on the ids, which grow along the list
+const size_t Topic::find(const unsigned int id) const
+{
+    size_t lo = 0, hi = subs.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (subs[mid]->id < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Private method: retire
+// Waits for the publishers that pinned the subscriber. They signal the
+// condition each time they are done with a batch.
+void Topic::retire(tSubscription *s)
+{
+    while (s->busy > 0) mutex.wait();
+    delete s;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Topic
+// Creates a topic with no subscribers
+Topic::Topic()
+:
+    /* Attribute construction */
+    subs(),
+    nextid(0),
+    delivered(0),
+    filtered(0),
+    failed(0),
+    mutex(),
+
+    /* Superclass construction */
+    Channel("Topic")
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public desctructor: ~Topic
+// Removes the subscribers
+Topic::~Topic()
+{
+    close();
+}
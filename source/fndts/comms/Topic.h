@@ -0,0 +1,156 @@
+// Foundations library (fndts): Topic class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Topic.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Topic class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "Channel.h"
+#include "Message.h"
+#include "Filter.h"
+#include "os/thread/CondThread.h"
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { class Topic; } }
+
+/**
+ *  \ingroup comms
+ *  \brief   A fan-out channel sending each published Message to the
+ *           subscribers whose Filter accepts it.
+ *
+ *  Each subscriber is a Channel (usually a Queue) with a Filter. Filters
+ *  are evaluated by the publisher, once per message and subscriber, so a
+ *  message is only copied into the channels that want it and a subscriber
+ *  is never woken up for a message it would throw away. Type filters read
+ *  the type from the message header, without looking at the payload.
+ *
+ *  The subscribers are sent to without holding the mutex of the topic, so
+ *  a subscriber that waits for room (a bounded Queue, a Pipeline) holds up
+ *  only its publisher, not the others nor subscribe(). The subscribers a
+ *  publisher is sending to are pinned: unsubscribe() and close() wait until
+ *  those sends are done, so the channel gets nothing once they return and
+ *  may be destroyed then. Thus, they must not be called from the send() of
+ *  a subscriber channel.
+ *
+ *  A topic cannot be used to receive: subscribers receive from their own
+ *  channels and receive() always fails.
+**/
+class fndts::comms::Topic : public fndts::comms::Channel
+{
+    private:
+        /* A subscriber */
+        struct tSubscription
+        {
+            unsigned int id;    /* Subscription identifier */
+            Channel *target;    /* Where accepted messages are sent */
+            Filter filter;      /* What it wants */
+            unsigned int busy;  /* Publishers sending to it */
+        };
+
+        std::vector<tSubscription*> subs;   /* The subscribers, by id */
+        unsigned int nextid;    /* Next subscription identifier */
+        volatile unsigned long delivered;   /* Messages sent to subscribers */
+        volatile unsigned long filtered;    /* Messages not sent to them */
+        volatile unsigned long failed;      /* Sends refused by them */
+        fndts::os::CondThread mutex;    /* Mutex for object members;
+                                         * signaled when a send is done */
+
+        /* Copy constructor and assignment operator disabled */
+        Topic(const Topic & src):Channel("disabled") {}
+        Topic & operator = (const Topic & src) { return *this; }
+
+        /* Gets the position of the first subscriber from the given id */
+        const size_t find(const unsigned int id) const;
+
+        /* Waits until no publisher sends to the removed subscriber and
+         * frees it. The mutex must be locked. */
+        void retire(tSubscription *s);
+
+    public:
+        /**
+         *  \brief  Creates a topic with no subscribers.
+        **/
+        Topic();
+
+        /**
+         *  \brief  Destroys the topic.
+        **/
+        virtual ~Topic();
+
+        /**
+         *  \brief  Removes all the subscribers, waiting for the sends to
+         *          them in progress.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message to every subscriber accepting it.
+         *  \param  m   Message to send.
+         *  \return true if every accepting subscriber got it; false,
+         *          otherwise.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Always fails: receive from the subscriber channels.
+         *  \param  r   Not used.
+         *  \return false
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Adds a subscriber.
+         *  \param  c   The channel where accepted messages are sent. It must
+         *              outlive the subscription.
+         *  \param  f   What the subscriber wants.
+         *  \return The subscription identifier.
+        **/
+        const unsigned int subscribe(Channel & c, const Filter & f = Filter());
+
+        /**
+         *  \brief  Removes a subscriber, waiting for the sends to it in
+         *          progress.
+         *  \param  id  The subscription identifier.
+         *  \return true if removed; false if it did not exist.
+        **/
+        const bool unsubscribe(const unsigned int id);
+
+        /**
+         *  \brief  Gets the number of subscribers.
+         *  \return The number of subscribers.
+        **/
+        const size_t getSubscriberCount();
+
+        /**
+         *  \brief  Gets the number of copies sent to subscribers.
+         *  \return The number of deliveries.
+        **/
+        inline const unsigned long getDeliveredCount() const
+        { return delivered; }
+
+        /**
+         *  \brief  Gets the number of times a filter rejected a message.
+         *  \return The number of filtered deliveries.
+        **/
+        inline const unsigned long getFilteredCount() const
+        { return filtered; }
+
+        /**
+         *  \brief  Gets the number of copies a subscriber did not accept.
+         *  \return The number of failed deliveries.
+        **/
+        inline const unsigned long getFailedCount() const
+        { return failed; }
+};
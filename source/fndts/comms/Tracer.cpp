@@ -0,0 +1,99 @@
+// Communications library (COMMS): Tracer class implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Tracer.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Tracer class implementation file.
+**/
+
+#include "Tracer.h"
+#include "Message.h"
+#include "LatencyHistogram.h"
+#include "os/time/Clock.h"
+
+using namespace fndts::comms;
+using fndts::os::Clock;
+using fndts::os::tNanos;
+
+/* Messages seen by start() in the current thread */
+static __thread unsigned int __comms_traceCounter = 0;
+
+/* Nanoseconds since the origin, saturated to fit in a hop stamp */
+static inline unsigned int __comms_traceStamp(const tNanos origin, 
+                                              const tNanos t)
+{
+    tNanos d = t - origin;
+    return d > 0xffffffffULL ? 0xffffffffU : static_cast<unsigned int>(d);
+}
+
+/* -- Static member initialization ------------------------------------------ */
+volatile unsigned int Tracer::sampling = 0;
+
+/* -- Object methods -------------------------------------------------------- */
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: setSampling
+// Sets the sampling
+void Tracer::setSampling(const unsigned int n)
+{
+    sampling = n;
+}
+
+// Public class method: start
+// Attaches a new trace header to one message out of N seen by the thread.
+const bool Tracer::start(Message & m)
+{
+    unsigned int n = sampling;
+    if (n == 0) return false;
+    if (++__comms_traceCounter < n) return false;
+    __comms_traceCounter = 0;
+
+    tTraceHeader h;
+    h.origin = Clock::now();
+    h.last = h.origin;
+    h.hops = 0;
+    m.setTrace(&h);
+    return true;
+}
+
+// Public class method: enqueue
+// Stamps the entry in a new hop
+void Tracer::enqueue(Message & m)
+{
+    tTraceHeader *h = m.getTrace();
+    if (h == NULL) return;
+
+    h->last = Clock::now();
+    if (h->hops < TRACE_MAXHOPS)
+    {
+        h->hop[h->hops].enqueue = __comms_traceStamp(h->origin, h->last);
+        h->hop[h->hops].dequeue = 0;
+    }
+    h->hops++;
+}
+
+// Public class method: dequeue
+// Stamps the exit of the current hop and records the latencies
+void Tracer::dequeue(Message & m, LatencyHistogram & queue, 
+                     LatencyHistogram & transit)
+{
+    tTraceHeader *h = m.getTrace();
+    if (h == NULL || h->hops == 0) return;
+
+    tNanos t = Clock::now();
+    if (h->hops <= TRACE_MAXHOPS)
+        h->hop[h->hops-1].dequeue = __comms_traceStamp(h->origin, t);
+    queue.record(t - h->last);
+    transit.record(t - h->origin);
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+/* -- Destructor ------------------------------------------------------------ */
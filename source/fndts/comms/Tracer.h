@@ -0,0 +1,122 @@
+// Foundations library (fndts): Tracer class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Tracer.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Tracer class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/time/Clock.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms { 
+    class Tracer; 
+    class Message;
+    class LatencyHistogram;
+
+    /** \brief  Number of hops whose stamps are kept in a trace. **/
+    const unsigned int TRACE_MAXHOPS = 8;
+
+    /**
+     *  \brief  The stamps of one hop (a pass through a Channel), in 
+     *          nanoseconds since the origin of the trace (saturated).
+    **/
+    struct tTraceHop
+    {
+        unsigned int enqueue;   /**< Time when sent to the channel **/
+        unsigned int dequeue;   /**< Time when received from the channel **/
+    };
+
+    /**
+     *  \brief  The trace carried by a traced Message.
+    **/
+    struct tTraceHeader
+    {
+        fndts::os::tNanos origin;   /**< Time when the trace started **/
+        fndts::os::tNanos last;     /**< Time of the last enqueue **/
+        unsigned int hops;          /**< Hops done (may exceed the kept) **/
+        tTraceHop hop[TRACE_MAXHOPS];   /**< Stamps of the first hops **/
+    };
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   End-to-end latency tracing of Message objects.
+ *
+ *  A traced Message carries a small trace header with the time it was
+ *  created (the origin) and the times it was sent to and received from each
+ *  Channel it went through (the hops). Channels fold these stamps into their
+ *  latency histograms when the message is received:
+ *
+ *      - the queue latency: time spent inside the channel.
+ *      - the transit latency: time since the origin.
+ *
+ *  Tracing is sampled: start() only attaches a header to one message out of
+ *  N (see setSampling()). Messages without header only cost the check of a
+ *  null pointer in the channels. The sampling counter is kept per thread.
+ *
+ *  Example:
+ *  \code
+ *  Tracer::setSampling(100);       // trace 1 message out of 100
+ *  Message m(sz, data);
+ *  Tracer::start(m);
+ *  q.send(m);
+ *  ...
+ *  q.getQueueLatency().getPercentile(99);
+ *  \endcode
+**/
+class fndts::comms::Tracer
+{
+    private:
+        static volatile unsigned int sampling;  /* Trace 1 out of N */
+
+        /* Only class methods: construction disabled */
+        Tracer() {}
+
+    public:
+        /**
+         *  \brief  Sets the sampling of the traces.
+         *  \param  n   Trace one message out of n (0 disables tracing).
+        **/
+        static void setSampling(const unsigned int n);
+
+        /**
+         *  \brief  Gets the sampling of the traces.
+         *  \return One message out of this number is traced (0: disabled).
+        **/
+        static inline const unsigned int getSampling()
+        { return sampling; }
+
+        /**
+         *  \brief  Starts the trace of a message if it is sampled.
+         *  \param  m   The message, usually just created.
+         *  \return true if the message is traced; false, otherwise.
+        **/
+        static const bool start(Message & m);
+
+        /**
+         *  \brief  Stamps a traced message entering a channel.
+         *  \param  m   The message.
+        **/
+        static void enqueue(Message & m);
+
+        /**
+         *  \brief  Stamps a traced message leaving a channel and records its
+         *          latencies.
+         *  \param  m       The message.
+         *  \param  queue   Histogram of the time spent in the channel.
+         *  \param  transit Histogram of the time since the origin.
+        **/
+        static void dequeue(Message & m, LatencyHistogram & queue, 
+                            LatencyHistogram & transit);
+};
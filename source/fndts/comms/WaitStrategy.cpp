@@ -0,0 +1,174 @@
+// Communications library (COMMS): WaitStrategy classes implementation -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the RoW:D game. This library is intended for personal
+// use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   WaitStrategy.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %WaitStrategy class and its subclasses implementation file.
+**/
+
+#include "WaitStrategy.h"
+#include <sched.h>
+#include <time.h>
+
+using namespace fndts::comms;
+using fndts::os::FutexThread;
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: BusySpinWait::wait
+// Polls until an item is taken
+void BusySpinWait::wait(FutexThread & c) const
+{
+    while (!c.tryWait())
+        FutexThread::relax();
+}
+
+// Public method: YieldWait::wait
+// Polls for a while, then yields between polls
+void YieldWait::wait(FutexThread & c) const
+{
+    for (unsigned int i=0; i<spins; i++)
+    {
+        if (c.tryWait()) return;
+        FutexThread::relax();
+    }
+    while (!c.tryWait())
+        sched_yield();
+}
+
+// Public method: BackoffWait::wait
+// Sleeps between polls doubling the sleep each time up to the maximum
+void BackoffWait::wait(FutexThread & c) const
+{
+    unsigned long ns = minsleep;
+    while (!c.tryWait())
+    {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        nanosleep(&ts, NULL);
+        if (ns < maxsleep) ns = (2*ns < maxsleep) ? 2*ns : maxsleep;
+    }
+}
+
+// Public method: BlockingWait::wait
+// Parks without spinning
+void BlockingWait::wait(FutexThread & c) const
+{
+    c.wait(0);
+}
+
+// Public method: HybridWait::wait
+// Spins, yields and then parks
+void HybridWait::wait(FutexThread & c) const
+{
+    for (unsigned int i=0; i<spins; i++)
+    {
+        if (c.tryWait()) return;
+        FutexThread::relax();
+    }
+    for (unsigned int i=0; i<yields; i++)
+    {
+        if (c.tryWait()) return;
+        sched_yield();
+    }
+    c.wait(0);
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Protected constructor: WaitStrategy
+// Does nothing
+WaitStrategy::WaitStrategy()
+{
+}
+
+// Public constructor: BusySpinWait
+// Does nothing
+BusySpinWait::BusySpinWait()
+:
+    /* Superclass construction */
+    WaitStrategy()
+{
+}
+
+// Public constructor: YieldWait
+// Sets the spin count
+YieldWait::YieldWait(const unsigned int s)
+:
+    /* Attribute construction */
+    spins(s),
+
+    /* Superclass construction */
+    WaitStrategy()
+{
+}
+
+// Public constructor: BackoffWait
+// Sets the sleep bounds
+BackoffWait::BackoffWait(const unsigned long mn, const unsigned long mx)
+:
+    /* Attribute construction */
+    minsleep(mn > 0 ? mn : 1),
+    maxsleep(mx > mn ? mx : mn),
+
+    /* Superclass construction */
+    WaitStrategy()
+{
+}
+
+// Public constructor: BlockingWait
+// Does nothing
+BlockingWait::BlockingWait()
+:
+    /* Superclass construction */
+    WaitStrategy()
+{
+}
+
+// Public constructor: HybridWait
+// Sets the spin and yield counts
+HybridWait::HybridWait(const unsigned int s, const unsigned int y)
+:
+    /* Attribute construction */
+    spins(s),
+    yields(y),
+
+    /* Superclass construction */
+    WaitStrategy()
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructors
+// Do nothing
+WaitStrategy::~WaitStrategy()
+{
+}
+
+BusySpinWait::~BusySpinWait()
+{
+}
+
+YieldWait::~YieldWait()
+{
+}
+
+BackoffWait::~BackoffWait()
+{
+}
+
+BlockingWait::~BlockingWait()
+{
+}
+
+HybridWait::~HybridWait()
+{
+}
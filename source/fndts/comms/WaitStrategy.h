@@ -0,0 +1,166 @@
+// Foundations library (fndts): WaitStrategy class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   WaitStrategy.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %WaitStrategy class and its subclasses header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/thread/FutexThread.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace comms {
+    class WaitStrategy;
+    class BusySpinWait;
+    class YieldWait;
+    class BackoffWait;
+    class BlockingWait;
+    class HybridWait;
+} }
+
+/**
+ *  \ingroup comms
+ *  \brief   How a channel consumer waits for a message.
+ *
+ *  Channels counting their messages with a FutexThread (Queue,
+ *  ConflatingQueue, ByteRing) take the strategy set with
+ *  Channel::setWaitStrategy() to wait for a message. Producers are not
+ *  affected: they only enter the kernel when a consumer is parked, which
+ *  only the blocking strategies do.
+ *
+ *  A strategy keeps no state about the waits, so one object may be shared
+ *  by many channels and threads. It must outlive the channels using it.
+**/
+class fndts::comms::WaitStrategy
+{
+    private:
+        /* Copy constructor and operator = disabled */
+        WaitStrategy(const WaitStrategy & src) {}
+        WaitStrategy & operator = (const WaitStrategy & src) { return *this; }
+
+    protected:
+        /**
+         *  \brief  Creates a strategy.
+        **/
+        WaitStrategy();
+
+    public:
+        /**
+         *  \brief  Destroys the strategy.
+        **/
+        virtual ~WaitStrategy();
+
+        /**
+         *  \brief  Takes one item from the counter, waiting until there is
+         *          one.
+         *  \param  c   The counter of available messages.
+        **/
+        virtual void wait(fndts::os::FutexThread & c) const = 0;
+};
+
+/**
+ *  \ingroup comms
+ *  \brief   Polls the counter without ever releasing the processor.
+ *
+ *  Lowest latency, but it burns a whole core. Only for dedicated cores.
+**/
+class fndts::comms::BusySpinWait : public fndts::comms::WaitStrategy
+{
+    public:
+        BusySpinWait();
+        virtual ~BusySpinWait();
+        virtual void wait(fndts::os::FutexThread & c) const;
+};
+
+/**
+ *  \ingroup comms
+ *  \brief   Polls the counter for a while and then yields the processor
+ *           between polls.
+**/
+class fndts::comms::YieldWait : public fndts::comms::WaitStrategy
+{
+    private:
+        unsigned int spins;     /* Polls before yielding */
+
+    public:
+        /**
+         *  \brief  Creates the strategy.
+         *  \param  s   Number of polls before yielding.
+        **/
+        explicit YieldWait(const unsigned int s = 100);
+        virtual ~YieldWait();
+        virtual void wait(fndts::os::FutexThread & c) const;
+};
+
+/**
+ *  \ingroup comms
+ *  \brief   Sleeps between polls, doubling the sleep up to a maximum.
+ *
+ *  Cheap on shared cores; the latency is up to the maximum sleep.
+**/
+class fndts::comms::BackoffWait : public fndts::comms::WaitStrategy
+{
+    private:
+        unsigned long minsleep; /* First sleep in nanoseconds */
+        unsigned long maxsleep; /* Longest sleep in nanoseconds */
+
+    public:
+        /**
+         *  \brief  Creates the strategy.
+         *  \param  mn  First sleep in nanoseconds.
+         *  \param  mx  Longest sleep in nanoseconds.
+        **/
+        BackoffWait(const unsigned long mn = 1000,
+                    const unsigned long mx = 1000000);
+        virtual ~BackoffWait();
+        virtual void wait(fndts::os::FutexThread & c) const;
+};
+
+/**
+ *  \ingroup comms
+ *  \brief   Parks in the kernel at once until a message is posted.
+ *
+ *  No processor time is used while waiting, at the cost of a wake up
+ *  system call on the producer and a context switch on the consumer.
+**/
+class fndts::comms::BlockingWait : public fndts::comms::WaitStrategy
+{
+    public:
+        BlockingWait();
+        virtual ~BlockingWait();
+        virtual void wait(fndts::os::FutexThread & c) const;
+};
+
+/**
+ *  \ingroup comms
+ *  \brief   Spins, then yields and finally parks in the kernel.
+ *
+ *  With no strategy set, channels wait spinning the counter spin count and
+ *  then parking, which is this strategy with no yields.
+**/
+class fndts::comms::HybridWait : public fndts::comms::WaitStrategy
+{
+    private:
+        unsigned int spins;     /* Polls before yielding */
+        unsigned int yields;    /* Yields before parking */
+
+    public:
+        /**
+         *  \brief  Creates the strategy.
+         *  \param  s   Number of polls before yielding.
+         *  \param  y   Number of yields before parking.
+        **/
+        HybridWait(const unsigned int s = 100, const unsigned int y = 10);
+        virtual ~HybridWait();
+        virtual void wait(fndts::os::FutexThread & c) const;
+};
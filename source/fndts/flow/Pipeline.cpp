@@ -0,0 +1,162 @@
+// Foundations library (flow): Pipeline class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own
+// program.
+
+/**
+ *  \file   Pipeline.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Pipeline class implementation file.
+**/
+
+#include <iomanip>
+#include "Pipeline.h"
+#include "Stage.h"
+
+using namespace fndts::flow;
+using fndts::comms::Message;
+using fndts::comms::Queue;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: add
+// Appends a stage while the pipeline is not running
+const bool Pipeline::add(Stage & s)
+{
+    if (running) return false;
+    stages.push_back(&s);
+    return true;
+}
+
+// Public method: start
+// Creates the queue in front of each stage and launches the stages, the last
+// one first, so that every stage finds its output ready
+const bool Pipeline::start()
+{
+    if (running) return false;
+    for (size_t i=0; i<queues.size(); i++) delete queues[i];
+    queues.clear();
+    for (size_t i=0; i<stages.size(); i++)
+        queues.push_back(new Queue(capacity));
+    for (size_t i=stages.size(); i-- > 0; )
+    {
+        comms::Channel *next = (i+1 < stages.size()) ?
+                               (comms::Channel *)queues[i+1] : &output;
+        stages[i]->start(*queues[i], *next);
+    }
+    running = true;
+    return true;
+}
+
+// Public method: stop
+// Finishes the stages in order: a stage is only told that nothing more will
+// come once the previous one has sent its last output
+void Pipeline::stop()
+{
+    if (!running) return;
+    running = false;
+    for (size_t i=0; i<stages.size(); i++)
+        stages[i]->finish();
+}
+
+// Public method: getBottleneck
+// Returns the most utilized stage
+Stage * Pipeline::getBottleneck() const
+{
+    Stage *b = NULL;
+    for (size_t i=0; i<stages.size(); i++)
+        if (b == NULL || stages[i]->getUtilization() > b->getUtilization())
+            b = stages[i];
+    return b;
+}
+
+// Public method: report
+// Writes the figures of each stage
+void Pipeline::report(std::ostream & o) const
+{
+    Stage *b = getBottleneck();
+    o << std::left << std::setw(20) << "stage" << std::right
+      << std::setw(9) << "replicas" << std::setw(12) << "processed"
+      << std::setw(10) << "dropped" << std::setw(8) << "util%"
+      << std::setw(9) << "backlog" << std::endl;
+    for (size_t i=0; i<stages.size(); i++)
+    {
+        Stage *s = stages[i];
+        o << std::left << std::setw(20) << s->getName() << std::right
+          << std::setw(9) << s->getReplicas()
+          << std::setw(12) << s->getProcessedCount()
+          << std::setw(10) << s->getDroppedCount()
+          << std::setw(8) << std::fixed << std::setprecision(1)
+          << 100 * s->getUtilization()
+          << std::setw(9) << s->getBacklog()
+          << (s == b ? "  <- bottleneck" : "") << std::endl;
+    }
+}
+
+// Public method: close
+// Stops the stages and drops the outputs
+const bool Pipeline::close()
+{
+    stop();
+    return output.close();
+}
+
+// Public method: send
+// Sends to the queue of the first stage, or straight to the output when
+// there are no stages
+const bool Pipeline::send(const Message & m)
+{
+    if (!running) return false;
+    if (queues.empty()) return output.send(m);
+    return queues[0]->send(m);
+}
+
+// Public method: receive
+// Receives an output
+const bool Pipeline::receive(Message & r)
+{
+    return output.receive(r);
+}
+
+// Public method: receive
+// Receives an output waiting for a limited time
+const bool Pipeline::receive(Message & r, const fndts::os::tNanos t)
+{
+    return output.receive(r, t);
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Pipeline
+// Creates a pipeline without stages
+Pipeline::Pipeline(const std::string & n, const size_t c)
+:
+    /* Attribute construction */
+    stages(),
+    queues(),
+    output(),
+    capacity(c > 0 ? c : 1),
+    running(false),
+
+    /* Superclass construction */
+    Channel(n)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Pipeline
+// Stops the stages and frees the queues
+Pipeline::~Pipeline()
+{
+    stop();
+    for (size_t i=0; i<queues.size(); i++) delete queues[i];
+}
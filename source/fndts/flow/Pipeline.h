@@ -0,0 +1,154 @@
+// Foundations library (fndts): Pipeline class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Pipeline.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Pipeline class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "comms/Channel.h"
+#include "comms/Message.h"
+#include "comms/Queue.h"
+#include "os/time/Clock.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace flow {
+    class Pipeline;
+    class Stage;
+} }
+
+/**
+ *  \ingroup flow
+ *  \brief   A Channel passing the messages sent to it through a chain of
+ *           Stage objects.
+ *
+ *  The pipeline connects each stage to the next one with a bounded Queue.
+ *  When a stage falls behind, its input queue fills up and the replicas of
+ *  the previous stage wait to send, up to the senders of the pipeline:
+ *  memory stays bounded and the whole chain runs at the pace of its
+ *  slowest stage. The outputs of the last stage are queued, without bound,
+ *  to be received from the pipeline.
+ *
+ *  Only a linear chain is built: each stage feeds the one added after it.
+ *  There is no fan-out to several stages nor merging of several stages into
+ *  one; to fan out, subscribe several pipelines, which are channels, to a
+ *  Topic.
+ *  \code
+ *  Pipeline p("decode", 256);
+ *  p.add(parse);           // stages, subclasses of Stage
+ *  p.add(transform);
+ *  p.start();
+ *  p.send(m);
+ *  p.receive(r);
+ *  p.stop();
+ *  p.report(std::cout);    // the busiest stage is the bottleneck
+ *  \endcode
+**/
+class fndts::flow::Pipeline : public fndts::comms::Channel
+{
+    private:
+        std::vector<Stage*> stages;     /* The stages, in order */
+        std::vector<comms::Queue*> queues;  /* Input queue of each stage */
+        comms::Queue output;        /* Outputs of the last stage */
+        size_t capacity;            /* Capacity of the input queues */
+        bool running;               /* Started and not stopped */
+
+        /* Copy constructor and assignment operator disabled */
+        Pipeline(const Pipeline & src):Channel("disabled") {}
+        Pipeline & operator = (const Pipeline & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates an empty pipeline.
+         *  \param  n   The name of the pipeline.
+         *  \param  c   The capacity of the queue in front of each stage.
+        **/
+        Pipeline(const std::string & n, const size_t c = 1024);
+
+        /**
+         *  \brief  Stops the pipeline.
+        **/
+        virtual ~Pipeline();
+
+        /**
+         *  \brief  Appends a stage. Stages cannot be added once started.
+         *  \param  s   The stage, which must outlive the pipeline.
+         *  \return true if added; false if the pipeline is running.
+        **/
+        const bool add(Stage & s);
+
+        /**
+         *  \brief  Launches the replicas of all the stages.
+         *  \return true if started; false if it was running.
+        **/
+        const bool start();
+
+        /**
+         *  \brief  Lets each stage, from the first to the last, process its
+         *          pending messages and stops it. The outputs can still be
+         *          received afterwards.
+        **/
+        void stop();
+
+        /**
+         *  \brief  Gets the stages.
+         *  \return The stages, in order.
+        **/
+        inline const std::vector<Stage*> & getStages() const
+        { return stages; }
+
+        /**
+         *  \brief  Gets the stage with the highest utilization.
+         *  \return The stage; NULL if there are no stages.
+        **/
+        Stage * getBottleneck() const;
+
+        /**
+         *  \brief  Writes a line per stage with its replicas, messages,
+         *          utilization and backlog, marking the bottleneck.
+         *  \param  o   The stream to write to.
+        **/
+        void report(std::ostream & o) const;
+
+        /**
+         *  \brief  Stops the pipeline and drops the outputs not received.
+         *  \return true.
+        **/
+        virtual const bool close();
+
+        /**
+         *  \brief  Sends a Message to the first stage, waiting while its
+         *          queue is full.
+         *  \param  m   Message to send.
+         *  \return true if sent; false if the pipeline is not running.
+        **/
+        virtual const bool send(const comms::Message & m);
+
+        /**
+         *  \brief  Receives an output of the last stage.
+         *  \param  r   The received message will be written here.
+         *  \return true if everything ok; false, otherwise.
+        **/
+        virtual const bool receive (comms::Message & r);
+
+        /**
+         *  \brief  Receives an output waiting for a limited time.
+         *  \param  r   The received message will be written here.
+         *  \param  t   Maximum time to wait in nanoseconds.
+         *  \return true if a message was received; false, otherwise.
+        **/
+        const bool receive (comms::Message & r, const fndts::os::tNanos t);
+};
@@ -0,0 +1,235 @@
+// Foundations library (flow): Stage class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own
+// program.
+
+/**
+ *  \file   Stage.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Stage class implementation file.
+**/
+
+#include <sstream>
+#include "Stage.h"
+#include "os/thread/Thread.h"
+
+using namespace fndts::flow;
+using fndts::comms::Message;
+using fndts::os::Clock;
+
+/* Time a replica waits for input before checking whether to finish */
+#define FLOW_POLL       10000000ULL
+
+/* A replica thread of a stage */
+class Stage::Replica : public fndts::os::Thread
+{
+    private:
+        Stage & stage;
+
+    protected:
+        /* Runs the stage */
+        virtual void * threadStartRoutine(void *arg)
+        {
+            stage.run();
+            return NULL;
+        }
+
+    public:
+        Replica(const std::string & n, Stage & s):Thread(n),stage(s) {}
+};
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public method: getUtilization
+// Busy time over the time the replicas have been running
+const double Stage::getUtilization() const
+{
+    if (started == 0) return 0;
+    fndts::os::tNanos end = (stopped != 0) ? stopped : Clock::now();
+    if (end <= started) return 0;
+    return (double)busy / ((double)(end - started) * replicas);
+}
+
+// Public method: getBacklog
+// Returns the size of the input queue
+const size_t Stage::getBacklog() const
+{
+    return (input != NULL) ? input->size() : 0;
+}
+
+// Private method: start
+// Connects the stage and launches the replicas
+void Stage::start(comms::Queue & in, comms::Channel & out)
+{
+    input = &in;
+    output = &out;
+    upstreamdone = false;
+    emitted = 0;
+    pending.clear();
+    started = Clock::now();
+    stopped = 0;
+    for (unsigned int i=0; i<replicas; i++)
+    {
+        std::ostringstream s;
+        s << name << " " << i;
+        threads.push_back(new Replica(s.str(), *this));
+        threads.back()->launch(NULL);
+    }
+}
+
+// Private method: finish
+// Tells the replicas that nothing more will come and joins them, once they
+// have emptied the input queue
+void Stage::finish()
+{
+    upstreamdone = true;
+    for (size_t i=0; i<threads.size(); i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+    if (!threads.empty()) stopped = Clock::now();
+    threads.clear();
+}
+
+// Private method: take
+// Waits for a message and takes as many more as the backlog share of each
+// replica, up to the maximum batch. Replicas wait on the queue, not on each
+// other: the queue numbers the messages. An ordered stage first waits while
+// too many outputs are held back.
+const size_t Stage::take(std::vector<Message> & batch,
+                         std::vector<unsigned long long> & nums)
+{
+    if (ordered && replicas > 1)
+    {
+        emitmutex.lock();
+        while (pending.size() >= window) emitmutex.wait();
+        emitmutex.unlock();
+    }
+    if (!input->receive(batch[0], FLOW_POLL, nums[0])) return 0;
+    size_t want = input->size() / replicas + 1;
+    if (want > maxbatch) want = maxbatch;
+    size_t n = 1;
+    while (n < want && input->tryReceive(batch[n], nums[n]))
+        n++;
+    return n;
+}
+
+// Private method: emit
+// Sends the kept outputs. An ordered stage with several replicas sends each
+// one only when all the earlier ones are gone, holding it back otherwise;
+// the replica completing a gap sends the held outputs that follow, and wakes
+// up the replicas waiting for room to take more.
+void Stage::emit(const std::vector<unsigned long long> & nums,
+                 const size_t n, std::vector<Message> & out,
+                 const std::vector<bool> & keep)
+{
+    if (!ordered || replicas == 1)
+    {
+        for (size_t i=0; i<n; i++)
+            if (keep[i]) output->send(out[i]);
+        return;
+    }
+
+    emitmutex.lock();
+    size_t held = pending.size();
+    for (size_t i=0; i<n; i++)
+    {
+        if (nums[i] != emitted)
+        {
+            tOutput & o = pending[nums[i]];
+            o.keep = keep[i];
+            if (keep[i]) o.message = out[i];
+            continue;
+        }
+        if (keep[i]) output->send(out[i]);
+        emitted++;
+        std::map<unsigned long long,tOutput>::iterator ite = pending.begin();
+        while (ite != pending.end() && ite->first == emitted)
+        {
+            if (ite->second.keep) output->send(ite->second.message);
+            pending.erase(ite++);
+            emitted++;
+        }
+    }
+    if (pending.size() < held) emitmutex.signal();
+    emitmutex.unlock();
+}
+
+// Private method: run
+// Processes batches until the input is empty and nothing more will come
+void Stage::run()
+{
+    std::vector<Message> in(maxbatch);
+    std::vector<Message> out(maxbatch);
+    std::vector<bool> keep(maxbatch);
+    std::vector<unsigned long long> nums(maxbatch);
+    while (true)
+    {
+        size_t n = take(in, nums);
+        if (n == 0)
+        {
+            if (upstreamdone && input->size() == 0) break;
+            continue;
+        }
+
+        fndts::os::tNanos t = Clock::now();
+        unsigned long nodrop = 0;
+        for (size_t i=0; i<n; i++)
+        {
+            out[i] = Message();
+            keep[i] = process(in[i], out[i]);
+            if (keep[i]) nodrop++;
+        }
+        __sync_fetch_and_add(&busy, Clock::now() - t);
+        __sync_fetch_and_add(&processed, n);
+        if (nodrop < n) __sync_fetch_and_add(&dropped, n - nodrop);
+
+        emit(nums, n, out, keep);
+    }
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Stage
+// Creates a stage not connected to any pipeline
+Stage::Stage(const std::string & n, const unsigned int r, const bool o,
+             const size_t b)
+:
+    /* Attribute construction */
+    name(n),
+    replicas(r > 0 ? r : 1),
+    ordered(o),
+    maxbatch(b > 0 ? b : 1),
+    input(NULL),
+    output(NULL),
+    threads(),
+    upstreamdone(false),
+    window(replicas * maxbatch),
+    emitted(0),
+    pending(),
+    processed(0),
+    dropped(0),
+    busy(0),
+    started(0),
+    stopped(0),
+    emitmutex()
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Stage
+// Joins the replicas left, if any
+Stage::~Stage()
+{
+    finish();
+}
@@ -0,0 +1,192 @@
+// Foundations library (fndts): Stage class definintion -*- C++-*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own program.
+
+/**
+ *  \file   Stage.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief  The %Stage class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "comms/Channel.h"
+#include "comms/Message.h"
+#include "comms/Queue.h"
+#include "os/thread/CondThread.h"
+#include "os/time/Clock.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace flow {
+    class Stage;
+    class Pipeline;
+} }
+
+/**
+ *  \ingroup flow
+ *  \brief   A processing step of a Pipeline, run by one or more replica
+ *           threads.
+ *
+ *  Subclasses implement process(), turning an input message into an output
+ *  message. A stage with several replicas must be stateless (or lock its
+ *  state), as process() is then called from several threads at once.
+ *
+ *  Replicas take messages from the input queue of the stage in batches,
+ *  whose size follows the backlog: one message at a time when the stage
+ *  keeps up, up to the maximum batch when messages pile up. An ordered
+ *  stage with several replicas uses the numbers the input queue gives the
+ *  messages as they are taken and holds back the outputs finished early,
+ *  so that they leave the stage in the order they came in. Replicas stop
+ *  taking messages while the held outputs reach replicas times the maximum
+ *  batch, so a slow message cannot make them pile up without bound.
+ *
+ *  The stage measures the time its replicas spend in process(): its
+ *  utilization tells how close to saturation it is, and the most utilized
+ *  stage of a pipeline is the one to give more replicas.
+**/
+class fndts::flow::Stage
+{
+    friend class Pipeline;
+
+    private:
+        class Replica;
+
+        /* An output waiting for the earlier ones */
+        struct tOutput
+        {
+            bool keep;              /* process() returned true */
+            comms::Message message; /* The output */
+        };
+
+        std::string name;           /* Name of the stage */
+        unsigned int replicas;      /* Number of replica threads */
+        bool ordered;               /* Outputs leave in the input order */
+        size_t maxbatch;            /* Most messages taken at once */
+        comms::Queue *input;        /* Where messages are taken from */
+        comms::Channel *output;     /* Where outputs are sent */
+        std::vector<Replica*> threads;  /* The running replicas */
+        volatile bool upstreamdone; /* Nothing more will be queued */
+        size_t window;              /* Most outputs held back */
+        unsigned long long emitted; /* Next number to leave the stage */
+        std::map<unsigned long long,tOutput> pending;   /* Held outputs */
+        volatile unsigned long processed;   /* Messages processed */
+        volatile unsigned long dropped;     /* Of them, without output */
+        volatile unsigned long long busy;   /* Time spent in process() */
+        fndts::os::tNanos started;  /* When the replicas were launched */
+        fndts::os::tNanos stopped;  /* When the last replica finished */
+        fndts::os::CondThread emitmutex;    /* Mutex for the held outputs */
+
+        /* Copy constructor and assignment operator disabled */
+        Stage(const Stage & src) {}
+        Stage & operator = (const Stage & src) { return *this; }
+
+        /* Launches the replicas */
+        void start(comms::Queue & in, comms::Channel & out);
+
+        /* Lets the replicas empty the input and joins them */
+        void finish();
+
+        /* Takes a batch; returns its size and the number of each message */
+        const size_t take(std::vector<comms::Message> & batch,
+                          std::vector<unsigned long long> & nums);
+
+        /* Sends the outputs of a batch, in order if needed */
+        void emit(const std::vector<unsigned long long> & nums,
+                  const size_t n, std::vector<comms::Message> & out,
+                  const std::vector<bool> & keep);
+
+        /* Body of the replicas */
+        void run();
+
+    protected:
+        /**
+         *  \brief  Processes a message.
+         *  \param  in  The input message.
+         *  \param  out The output message, to be written.
+         *  \return true to send the output to the next stage; false to
+         *          drop it.
+        **/
+        virtual const bool process(const comms::Message & in,
+                                   comms::Message & out) = 0;
+
+    public:
+        /**
+         *  \brief  Creates a stage.
+         *  \param  n   The name of the stage, prefix of the replica names.
+         *  \param  r   The number of replicas (at least 1).
+         *  \param  o   Keep the order of the messages across replicas.
+         *  \param  b   The most messages a replica takes at once.
+        **/
+        Stage(const std::string & n, const unsigned int r = 1,
+              const bool o = true, const size_t b = 32);
+
+        /**
+         *  \brief  Destroys the stage. Its pipeline must be stopped first, as
+         *          the replicas call the methods of the subclass.
+        **/
+        virtual ~Stage();
+
+        /**
+         *  \brief  Gets the name of the stage.
+         *  \return The name.
+        **/
+        inline const std::string getName() const
+        { return name; }
+
+        /**
+         *  \brief  Gets the number of replicas.
+         *  \return The number of replicas.
+        **/
+        inline const unsigned int getReplicas() const
+        { return replicas; }
+
+        /**
+         *  \brief  Tells whether outputs keep the input order.
+         *  \return true if they do.
+        **/
+        inline const bool isOrdered() const
+        { return ordered; }
+
+        /**
+         *  \brief  Gets the number of messages processed.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getProcessedCount() const
+        { return processed; }
+
+        /**
+         *  \brief  Gets the number of messages processed without output.
+         *  \return The number of messages.
+        **/
+        inline const unsigned long getDroppedCount() const
+        { return dropped; }
+
+        /**
+         *  \brief  Gets the time spent in process() by all the replicas.
+         *  \return The time in nanoseconds.
+        **/
+        inline const fndts::os::tNanos getBusyTime() const
+        { return busy; }
+
+        /**
+         *  \brief  Gets the share of the replicas' time spent in process()
+         *          since the stage was started.
+         *  \return The utilization, from 0 to 1.
+        **/
+        const double getUtilization() const;
+
+        /**
+         *  \brief  Gets the number of messages waiting in the input queue.
+         *  \return The number of messages; 0 if not started.
+        **/
+        const size_t getBacklog() const;
+};
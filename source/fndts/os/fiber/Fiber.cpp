@@ -0,0 +1,53 @@
+// Foundations library (os): Fiber class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for 
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file Fiber.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %Fiber class implementation file.
+**/
+
+#include <ucontext.h>
+#include "Fiber.h"
+#include "FiberScheduler.h"
+
+using namespace fndts::os;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+/* -- Class methods --------------------------------------------------------- */
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: Fiber
+// Creates a new fiber allocating its stack. The context is built when the
+// fiber is spawned.
+Fiber::Fiber(const size_t sz)
+:
+    /* Attributes construction */
+    stack(NULL),
+    stacksize(sz),
+    scheduler(NULL),
+    state(eFIBERNEW),
+    arg(NULL),
+    release(NULL)
+{
+    stack = new char[stacksize];
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~Fiber
+// Deallocates the stack of the fiber.
+Fiber::~Fiber()
+{
+    if (stack != NULL) delete []stack;
+}
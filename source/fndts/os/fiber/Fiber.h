@@ -0,0 +1,135 @@
+// Foundations library (fndts): Fiber class definintion -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file Fiber.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %Fiber class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <stddef.h>
+#include <ucontext.h>
+#include "misc/Mutex.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace os { 
+    class Fiber; 
+    class FiberScheduler;
+
+    /**
+     *  \brief  The states of a Fiber.
+    **/
+    enum eFiberState
+    {
+        eFIBERNEW      = 0,     /**< Created but not spawned yet. **/
+        eFIBERREADY    = 1,     /**< Waiting in the run queue. **/
+        eFIBERRUNNING  = 2,     /**< Being run by a scheduler thread. **/
+        eFIBERWAITING  = 3,     /**< Suspended until someone resumes it. **/
+        eFIBERFINISHED = 4      /**< Its entry point has returned. **/
+    };
+} }
+
+/**
+ *  \ingroup fndts
+ *  \brief  The %Fiber class.
+ *
+ *  This is an abstract class defining the behavior of any object willing to
+ *  become a fiber: a lightweight logical thread run cooperatively by one of
+ *  the threads of a FiberScheduler.
+ *
+ *  A %Fiber has its own (small) stack, so it can be suspended in the middle
+ *  of any call, for instance when waiting for a message in a FiberQueue, and
+ *  resumed later by any of the scheduler threads. Suspending a %Fiber does
+ *  not block the thread running it, which goes on running other fibers.
+ *  Thousands of fibers can then wait for messages using only a handful of
+ *  Thread objects.
+ *
+ *  A %Fiber is set to run calling FiberScheduler::spawn(). Inside the fiber,
+ *  the class methods of FiberScheduler (yield(), park()) are used to give
+ *  the CPU to other fibers.
+**/
+class fndts::os::Fiber
+{
+    private:
+        ucontext_t context;     /* Saved context of this fiber */
+        char *stack;            /* Stack of this fiber */
+        size_t stacksize;       /* Size in bytes of the stack */
+        FiberScheduler *scheduler;  /* Scheduler running this fiber */
+        volatile eFiberState state; /* Current state of the fiber */
+        void *arg;              /* Argument for the entry point */
+        fndts::Mutex *release;  /* Mutex to unlock once switched out */
+
+        /**
+         *  \brief  First function run on the new fiber stack.
+         *
+         *  makecontext() only passes int arguments, so the pointer to the
+         *  %Fiber object is split into two halves.
+        **/
+        static void onStartFiber(unsigned int hi, unsigned int lo);
+
+        /* Copy constructor and operator = disabled */
+        Fiber(const Fiber & src) {}
+        Fiber & operator = (const Fiber & src) { return *this; }
+
+    protected:
+        /**
+         *  \brief  The entry point of this fiber (Pure virtual method).
+         *  \param  arg The argument given to FiberScheduler::spawn().
+        **/
+        virtual void fiberStartRoutine(void *arg) = 0;
+
+    public:
+        /**
+         *  \brief  Creates a new %Fiber object.
+         *  \param  sz  Size in bytes of the fiber stack.
+        **/
+        explicit Fiber(const size_t sz = 65536);
+
+        /**
+         *  \brief  Destroys a %Fiber object.
+         *
+         *  The fiber must not be running nor waiting when destroyed.
+        **/
+        virtual ~Fiber();
+
+        /**
+         *  \brief  Gets the state of the fiber.
+         *  \return The state of the fiber (see eFiberState).
+        **/
+        inline const eFiberState getState() const
+        { return state; }
+
+        /**
+         *  \brief  Checks if the entry point of the fiber has returned.
+         *  \return true if the fiber is finished; false, otherwise.
+        **/
+        inline const bool isFinished() const
+        { return state == eFIBERFINISHED; }
+
+        /**
+         *  \brief  Gets the scheduler running this fiber.
+         *  \return The scheduler (NULL if the fiber was never spawned).
+        **/
+        inline FiberScheduler * getScheduler() const
+        { return scheduler; }
+
+        /**
+         *  \brief  Gets the size of the stack of the fiber.
+         *  \return The stack size in bytes.
+        **/
+        inline const size_t getStackSize() const
+        { return stacksize; }
+
+        /* Friend declarations. */
+        friend class FiberScheduler;
+};
@@ -0,0 +1,275 @@
+// Foundations library (os): FiberScheduler class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for 
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file FiberScheduler.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %FiberScheduler class implementation file.
+**/
+
+#include <sstream>
+#include <ucontext.h>
+#include "FiberScheduler.h"
+#include "Fiber.h"
+#include "os/thread/Thread.h"
+
+/* Default namespace */
+using namespace fndts::os;
+
+/* 
+ * The fiber being run and the context of the scheduler loop are kept per
+ * thread. They are accessed through non inlined functions because a fiber
+ * may be resumed by a thread different from the one which suspended it, so
+ * the compiler must not reuse a thread local address across a switch.
+*/
+static __thread Fiber *      __os_currentFiber   = NULL;
+static __thread ucontext_t * __os_workerContext  = NULL;
+
+static Fiber * __attribute__((noinline)) __os_getCurrentFiber()
+{ return __os_currentFiber; }
+static void __attribute__((noinline)) __os_setCurrentFiber(Fiber *f)
+{ __os_currentFiber = f; }
+static ucontext_t * __attribute__((noinline)) __os_getWorkerContext()
+{ return __os_workerContext; }
+static void __attribute__((noinline)) __os_setWorkerContext(ucontext_t *c)
+{ __os_workerContext = c; }
+
+/*
+ * The threads of the scheduler. They just run the scheduler loop.
+*/
+class fndts::os::__os_FiberWorker : public Thread
+{
+    private:   FiberScheduler *sched;
+    protected: virtual void * threadStartRoutine (void *arg) 
+               { sched->work(); return NULL; }
+    public:    __os_FiberWorker(const std::string & n, FiberScheduler *s)
+               : Thread(n), sched(s) { }
+};
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public object method: spawn
+// Builds the context of the fiber over its own stack and puts it in the run
+// queue.
+const bool FiberScheduler::spawn(Fiber & f, void *arg)
+{
+    if (f.state != eFIBERNEW && f.state != eFIBERFINISHED) return false;
+
+    /* Build the context: run onStartFiber on the fiber stack */
+    getcontext(&f.context);
+    f.context.uc_stack.ss_sp = f.stack;
+    f.context.uc_stack.ss_size = f.stacksize;
+    f.context.uc_link = NULL;
+    unsigned long p = reinterpret_cast<unsigned long>(&f);
+    makecontext(&f.context, reinterpret_cast<void (*)()>(Fiber::onStartFiber),
+                2, static_cast<unsigned int>((p >> 16) >> 16),
+                static_cast<unsigned int>(p & 0xffffffffUL));
+    f.scheduler = this;
+    f.arg = arg;
+    f.release = NULL;
+
+    /* Add it to the run queue */
+    runavail.lock();
+    live++;
+    f.state = eFIBERREADY;
+    runq.push_back(&f);
+    wakeWorker();
+    runavail.unlock();
+    return true;
+}
+
+// Public object method: ready
+// Puts a parked fiber back in the run queue.
+void FiberScheduler::ready(Fiber & f)
+{
+    runavail.lock();
+    f.state = eFIBERREADY;
+    runq.push_back(&f);
+    wakeWorker();
+    runavail.unlock();
+}
+
+// Public object method: join
+// Waits until all the spawned fibers have finished.
+void FiberScheduler::join()
+{
+    runavail.lock();
+    joining++;
+    while (live > 0)
+        runavail.wait();
+    joining--;
+    runavail.unlock();
+}
+
+// Private object method: wakeWorker
+// Wakes up one worker for a fiber just queued. Joining threads wait on the
+// same condition and could take the only wake up, so all the waiters are
+// woken up while there are some. The mutex must be locked.
+void FiberScheduler::wakeWorker()
+{
+    if (joining > 0) runavail.signal();
+    else runavail.signalOne();
+}
+
+// Private object method: work
+// The loop run by each thread: takes a fiber from the run queue, switches to
+// it and, once it is switched out, completes what the fiber asked for.
+void FiberScheduler::work()
+{
+    ucontext_t self;
+    __os_setWorkerContext(&self);
+
+    while (true)
+    {
+        /* Get a ready fiber */
+        runavail.lock();
+        while (runq.empty() && !stopping)
+            runavail.wait();
+        if (runq.empty())
+        {
+            runavail.unlock();
+            break;
+        }
+        Fiber *f = runq.front();
+        runq.pop_front();
+        runavail.unlock();
+
+        /* Run it until it finishes, yields or parks */
+        f->state = eFIBERRUNNING;
+        __os_setCurrentFiber(f);
+        swapcontext(&self, &f->context);
+        __os_setCurrentFiber(NULL);
+
+        /* 
+         * Once here, the fiber may only be touched before releasing it: a 
+         * finished fiber may be destroyed or spawned again by its owner and
+         * a parked one may be resumed by another thread. A fiber still
+         * running has returned from its start routine; it is only made
+         * finished here, as the owner may reuse it as soon as it sees it.
+        */
+        switch (f->state)
+        {
+            case eFIBERRUNNING:
+            {
+                runavail.lock();
+                f->state = eFIBERFINISHED;
+                if (--live == 0) runavail.signal();
+                runavail.unlock();
+                break;
+            }
+            case eFIBERWAITING:
+            {
+                fndts::Mutex *m = f->release;
+                f->release = NULL;
+                m->unlock();
+                break;
+            }
+            default:
+            {
+                ready(*f);
+            }
+        }
+    }
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: getCurrentFiber
+// Returns the fiber being run by the calling thread.
+Fiber * FiberScheduler::getCurrentFiber()
+{
+    return __os_getCurrentFiber();
+}
+
+// Public class method: yield
+// Switches back to the scheduler loop, which puts the fiber in the run queue
+void FiberScheduler::yield()
+{
+    Fiber *f = __os_getCurrentFiber();
+    if (f == NULL) return;
+
+    f->state = eFIBERREADY;
+    swapcontext(&f->context, __os_getWorkerContext());
+}
+
+// Public class method: park
+// Switches back to the scheduler loop, which unlocks the given mutex. The
+// fiber will stay out of the run queue until someone calls ready().
+const bool FiberScheduler::park(fndts::Mutex & m)
+{
+    Fiber *f = __os_getCurrentFiber();
+    if (f == NULL) return false;
+
+    f->release = &m;
+    f->state = eFIBERWAITING;
+    swapcontext(&f->context, __os_getWorkerContext());
+    return true;
+}
+
+// Private class method: Fiber::onStartFiber
+// First function run in the fiber stack. Rebuilds the pointer to the fiber,
+// runs its entry point and goes back to the scheduler loop for good. The
+// fiber is left running: the loop makes it finished once switched out.
+void Fiber::onStartFiber(unsigned int hi, unsigned int lo)
+{
+    unsigned long p = ((static_cast<unsigned long>(hi) << 16) << 16) | lo;
+    Fiber *f = reinterpret_cast<Fiber *>(p);
+
+    f->fiberStartRoutine(f->arg);
+
+    f->state = eFIBERRUNNING;
+    setcontext(__os_getWorkerContext());
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: FiberScheduler
+// Creates the scheduler and launches the given number of threads, named after
+// the scheduler.
+FiberScheduler::FiberScheduler(const std::string & n, const unsigned int t)
+:
+    /* Attributes construction */
+    name(n),
+    workers(),
+    runq(),
+    runavail(),
+    live(0),
+    joining(0),
+    stopping(false)
+{
+    for (unsigned int i=0; i<(t>0?t:1); i++)
+    {
+        std::ostringstream tname;
+        tname << name << "/" << i;
+        Thread *w = new __os_FiberWorker(tname.str(),this);
+        workers.push_back(w);
+        w->launch(NULL);
+    }
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~FiberScheduler
+// Asks the threads to finish once the run queue is empty and waits for them.
+FiberScheduler::~FiberScheduler()
+{
+    runavail.lock();
+    stopping = true;
+    runavail.signal();
+    runavail.unlock();
+
+    std::vector<Thread *>::iterator ite;
+    for (ite=workers.begin(); ite!=workers.end(); ite++)
+    {
+        (*ite)->join();
+        delete *ite;
+    }
+}
@@ -0,0 +1,153 @@
+// Foundations library (fndts): FiberScheduler class definintion -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file FiberScheduler.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %FiberScheduler class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <string>
+#include <deque>
+#include <vector>
+#include "Fiber.h"
+#include "misc/Mutex.h"
+#include "os/thread/Thread.h"
+#include "os/thread/CondThread.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace os { 
+    class FiberScheduler; 
+    class __os_FiberWorker;
+} }
+
+/**
+ *  \ingroup fndts
+ *  \brief  Runs Fiber objects on a small pool of Thread objects.
+ *
+ *  The %FiberScheduler keeps a run queue of ready fibers and a number of
+ *  threads taking fibers from it. Each thread runs a fiber until it returns,
+ *  yields or parks, and then takes the next one.
+ *
+ *  A fiber which needs to wait for something (a message, a free slot in a
+ *  queue...) registers itself somewhere its waker can find it and calls
+ *  park(). The waker then calls ready() on it. park() takes the mutex
+ *  protecting the registration: it is unlocked only after the fiber has been
+ *  switched out, so a waker can never resume a fiber which is still running.
+ *
+ *  Example:
+ *  \code
+ *  FiberScheduler sched("workers", 4);
+ *  sched.spawn(fiber1, NULL);
+ *  sched.spawn(fiber2, NULL);
+ *  sched.join();       // waits for all the fibers to finish
+ *  \endcode
+**/
+class fndts::os::FiberScheduler
+{
+    private:
+        std::string name;               /* Name of the scheduler */
+        std::vector<Thread *> workers;  /* Threads running the fibers */
+        std::deque<Fiber *> runq;       /* Fibers ready to run */
+        fndts::os::CondThread runavail; /* Run queue mutex and condition */
+        unsigned int live;              /* Fibers spawned but not finished */
+        unsigned int joining;           /* Threads waiting in join() */
+        bool stopping;                  /* Workers must finish */
+
+        /* Copy constructor and operator = disabled */
+        FiberScheduler(const FiberScheduler & src) {}
+        FiberScheduler & operator = (const FiberScheduler & src) 
+        { return *this; }
+
+        /* Loop run by each of the worker threads */
+        void work();
+
+        /* Wakes up a worker for a queued fiber. The mutex must be locked. */
+        void wakeWorker();
+
+        /* Friend declarations */
+        friend class __os_FiberWorker;
+
+    public:
+        /**
+         *  \brief  Creates a scheduler and launches its threads.
+         *  \param  n   Name of the scheduler. Threads are named after it.
+         *  \param  t   Number of threads running fibers.
+         *  \throw  ThreadException if the thread names are already in use.
+        **/
+        FiberScheduler(const std::string & n, const unsigned int t);
+
+        /**
+         *  \brief  Stops the threads and destroys the scheduler.
+        **/
+        virtual ~FiberScheduler();
+
+        /**
+         *  \brief  Sets a fiber to run in this scheduler.
+         *  \param  f   The fiber. It must not be running.
+         *  \param  arg Argument for the entry point of the fiber.
+         *  \return true if the fiber was scheduled; false, otherwise.
+        **/
+        const bool spawn(Fiber & f, void *arg);
+
+        /**
+         *  \brief  Puts back in the run queue a parked fiber.
+         *  \param  f   The fiber to resume.
+        **/
+        void ready(Fiber & f);
+
+        /**
+         *  \brief  Waits for all the spawned fibers to finish.
+        **/
+        void join();
+
+        /**
+         *  \brief  Gets the name of the scheduler.
+         *  \return The name of the scheduler.
+        **/
+        inline const std::string getName() const
+        { return name; }
+
+        /**
+         *  \brief  Gets the number of threads of the scheduler.
+         *  \return The number of threads.
+        **/
+        inline const unsigned int getThreadCount() const
+        { return workers.size(); }
+
+        /**
+         *  \brief  Gets the fiber being run by the calling thread.
+         *  \return The current fiber; NULL if the caller is not a fiber.
+        **/
+        static Fiber * getCurrentFiber();
+
+        /**
+         *  \brief  Gives the CPU to other ready fibers.
+         *
+         *  The current fiber is put at the end of the run queue. Does nothing
+         *  when the caller is not a fiber.
+        **/
+        static void yield();
+
+        /**
+         *  \brief  Suspends the current fiber until ready() is called on it.
+         *
+         *  The given mutex, which must be locked by the caller, is unlocked
+         *  once the fiber has been switched out. It is not locked again when
+         *  the fiber resumes.
+         *
+         *  \param  m   The mutex protecting the waiters registration.
+         *  \return false if the caller is not a fiber (m is left locked).
+        **/
+        static const bool park(fndts::Mutex & m);
+};
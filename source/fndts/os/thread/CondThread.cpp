@@ -44,6 +44,16 @@ int CondThread::signalOne()
     return pthread_cond_signal (&condition);
 }
 
+// Public Method: signal
+// Signals up to n of the waiting threads for this condition.
+int CondThread::signal(const unsigned int n)
+{
+    int r = 0;
+    for (unsigned int i=0; i<n && r==0; i++)
+        r = pthread_cond_signal (&condition);
+    return r;
+}
+
 /* -- Class methods --------------------------------------------------------- */
 
 /* -- Constructors ---------------------------------------------------------- */
@@ -68,4 +68,16 @@ class fndts::os::CondThread : public fndts::os::MutexThread
          *  \return The OS result of the call.
         **/
         int signalOne();
+
+        /**
+         *  \brief  Signal this condition to become true to the given number
+         *          of waiting threads.
+         *
+         *  Use it instead of signal() when n items have been made available,
+         *  so that no more waiters than needed are woken up.
+         *
+         *  \param  n   Number of threads to wake up.
+         *  \return The OS result of the last call.
+        **/
+        int signal(const unsigned int n);
 };
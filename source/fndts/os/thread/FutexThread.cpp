@@ -0,0 +1,142 @@
+// Foundations library (os): FutexThread class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasteis game. This library is intended for 
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file FutexThread.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %FutexThread class implementation file.
+**/
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "FutexThread.h"
+
+using namespace fndts::os;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+// Public Method: post
+// Adds the items and, if any thread is parked, wakes as many as items added.
+// Both the count update and the waiters check are full barriers: either the
+// poster sees the waiter registered or the waiter's futex call sees the new
+// count and does not sleep.
+void FutexThread::post(const unsigned int n)
+{
+    if (n == 0) return;
+    __sync_fetch_and_add(&count, n);
+    if (__sync_fetch_and_add(&waiters, 0) > 0)
+        wake(&count, n);
+}
+
+// Public Method: wait
+// Waits with the spin count of the object.
+void FutexThread::wait()
+{
+    wait(spins);
+}
+
+// Public Method: wait
+// Polls the count for a while and then parks in the kernel until an item is
+// posted. The kernel only parks the thread if the count is still 0.
+void FutexThread::wait(const unsigned int s)
+{
+    for (unsigned int i=0; i<s; i++)
+    {
+        if (tryWait()) return;
+        relax();
+    }
+
+    while (!tryWait())
+    {
+        __sync_fetch_and_add(&waiters, 1);
+        park(&count, 0);
+        __sync_fetch_and_sub(&waiters, 1);
+    }
+}
+
+// Public Method: timedWait
+// Like wait(), but parking the thread only until the deadline.
+const bool FutexThread::timedWait(const tNanos t)
+{
+    tNanos end = Clock::now() + t;
+    for (unsigned int i=0; i<spins; i++)
+    {
+        if (tryWait()) return true;
+        relax();
+    }
+
+    while (!tryWait())
+    {
+        tNanos now = Clock::now();
+        if (now >= end) return false;
+        struct timespec ts;
+        ts.tv_sec = (end - now) / 1000000000ULL;
+        ts.tv_nsec = (end - now) % 1000000000ULL;
+        __sync_fetch_and_add(&waiters, 1);
+        park(&count, 0, &ts);
+        __sync_fetch_and_sub(&waiters, 1);
+    }
+    return true;
+}
+
+// Public Method: tryWait
+// Takes one item if the count is positive.
+const bool FutexThread::tryWait()
+{
+    int c = count;
+    while (c > 0)
+    {
+        int prev = __sync_val_compare_and_swap(&count, c, c-1);
+        if (prev == c) return true;
+        c = prev;
+    }
+    return false;
+}
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: park
+// Parks the thread in the kernel if the word still holds the value, for a
+// relative time at most.
+void FutexThread::park(volatile int *word, const int value,
+                       const struct timespec *t)
+{
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, t, NULL, 0);
+}
+
+// Public class method: wake
+// Wakes up to n threads parked in the word.
+void FutexThread::wake(volatile int *word, const int n)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+// Public constructor: FutexThread
+// Initializes the count of items.
+FutexThread::FutexThread(const int c, const unsigned int s)
+:
+    /* Attributes construction */
+    count(c > 0 ? c : 0),
+    waiters(0),
+    spins(s)
+{
+}
+
+/* -- Destructor ------------------------------------------------------------ */
+
+// Public destructor: ~FutexThread
+// Nothing to release: a futex has no kernel state when nobody waits.
+FutexThread::~FutexThread()
+{
+}
@@ -0,0 +1,149 @@
+// Foundations library (fndts): FutexThread class definintion -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasteis game. This library is intended for 
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file FutexThread.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %FutexThread class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include "os/time/Clock.h"
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace os { class FutexThread; } }
+
+/**
+ *  \ingroup fndts
+ *  \brief  A counting wait/notify object built directly over a Linux futex.
+ *
+ *  The %FutexThread keeps a count of available items. post() adds items and
+ *  wait() takes one, waiting while there are none. Unlike a CondThread
+ *  broadcast, post() wakes only as many waiting threads as items were added,
+ *  so the rest of the waiters are not disturbed.
+ *
+ *  A waiting thread first spins for a while, polling the count, and only 
+ *  then parks in the kernel. Under load, items usually arrive during the
+ *  spin and no system call nor context switch is done. Likewise, post() only
+ *  enters the kernel when there are parked threads.
+**/
+class fndts::os::FutexThread
+{
+    private:
+        volatile int count;     /* Available items (the futex word) */
+        volatile int waiters;   /* Threads parked in the futex */
+        unsigned int spins;     /* Polls before parking */
+
+        /* Copy constructor and operator = disabled */
+        FutexThread(const FutexThread & src) {}
+        FutexThread & operator = (const FutexThread & src) { return *this; }
+
+    public:
+        /**
+         *  \brief  Creates a %FutexThread object.
+         *  \param  c   Initial count of items.
+         *  \param  s   Number of polls done before parking the thread.
+        **/
+        explicit FutexThread(const int c = 0, const unsigned int s = 100);
+
+        /**
+         *  \brief  Destroys a %FutexThread object.
+        **/
+        virtual ~FutexThread();
+
+        /**
+         *  \brief  Adds items and wakes up to that number of waiting threads.
+         *  \param  n   Number of items added.
+        **/
+        void post(const unsigned int n = 1);
+
+        /**
+         *  \brief  Takes one item, spinning and then parking while there are
+         *          none.
+        **/
+        void wait();
+
+        /**
+         *  \brief  Takes one item, spinning the given number of polls and
+         *          then parking while there are none.
+         *  \param  s   Number of polls before parking (0 parks at once).
+        **/
+        void wait(const unsigned int s);
+
+        /**
+         *  \brief  Takes one item, spinning and then parking while there are
+         *          none, for a limited time.
+         *  \param  t   Maximum time to wait in nanoseconds.
+         *  \return true if an item was taken; false if the time passed.
+        **/
+        const bool timedWait(const fndts::os::tNanos t);
+
+        /**
+         *  \brief  Takes one item, only if available.
+         *  \return true if an item was taken; false, otherwise.
+        **/
+        const bool tryWait();
+
+        /**
+         *  \brief  Gets the number of available items.
+         *  \return The number of items.
+        **/
+        inline const int getCount() const
+        { return count; }
+
+        /**
+         *  \brief  Gets the number of polls done before parking.
+         *  \return The spin count.
+        **/
+        inline const unsigned int getSpinCount() const
+        { return spins; }
+
+        /**
+         *  \brief  Sets the number of polls done before parking.
+         *  \param  s   The new spin count (0 parks at once).
+        **/
+        inline void setSpinCount(const unsigned int s)
+        { spins = s; }
+
+        /**
+         *  \brief  Parks the calling thread on a futex word while it holds
+         *          the given value.
+         *
+         *  This is the raw futex wait, for classes building their own wait
+         *  protocol. The call may return spuriously.
+         *
+         *  \param  word    The futex word.
+         *  \param  value   The value the word must hold to park.
+         *  \param  t       Maximum time to park (NULL for no limit).
+        **/
+        static void park(volatile int *word, const int value,
+                         const struct timespec *t = NULL);
+
+        /**
+         *  \brief  Wakes threads parked on a futex word.
+         *  \param  word    The futex word.
+         *  \param  n       Maximum number of threads to wake.
+        **/
+        static void wake(volatile int *word, const int n);
+
+        /**
+         *  \brief  Tells the CPU the caller is in a spin loop.
+        **/
+        static inline void relax()
+        {
+#if defined(__i386__) || defined(__x86_64__)
+            __asm__ __volatile__ ("pause" ::: "memory");
+#else
+            __asm__ __volatile__ ("" ::: "memory");
+#endif
+        }
+};
@@ -0,0 +1,38 @@
+// Foundations library (os): Clock class implementation -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for 
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file Clock.cpp
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %Clock class implementation file.
+**/
+
+#include <time.h>
+#include "Clock.h"
+
+using namespace fndts::os;
+
+/* -- Static member initialization ------------------------------------------ */
+
+/* -- Object methods -------------------------------------------------------- */
+
+/* -- Class methods --------------------------------------------------------- */
+
+// Public class method: getResolution
+// Asks the system for the resolution of the monotonic clock
+tNanos Clock::getResolution()
+{
+    struct timespec ts;
+    clock_getres(CLOCK_MONOTONIC, &ts);
+    return static_cast<tNanos>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/* -- Constructors ---------------------------------------------------------- */
+
+/* -- Destructor ------------------------------------------------------------ */
@@ -0,0 +1,64 @@
+// Foundations library (fndts): Clock class definintion -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file is part of the Dynasties game. This library is intended for
+// personal use only; you cannot redistribute it and/or use it in your own 
+// program.
+
+/**
+ *  \file Clock.h
+ *  \author Victor Garcia <vichor@gmail.com>
+ *  \brief The %Clock class header file.
+**/
+
+/* Avoid multiple inclusions */
+#pragma once
+
+/* Include files */
+#include <time.h>
+
+/* Namespace definition and forward declarations */
+namespace fndts { namespace os { 
+    class Clock; 
+
+    /**
+     *  \brief  A point in time or a duration, in nanoseconds.
+    **/
+    typedef unsigned long long tNanos;
+} }
+
+/**
+ *  \ingroup fndts
+ *  \brief  Cheap access to the monotonic clock of the system.
+ *
+ *  The clock is the CLOCK_MONOTONIC clock, which is read from user space
+ *  (no system call) in Linux. Its values are comparable between threads and
+ *  processes of the same machine, but they have no relation with the wall
+ *  clock time.
+**/
+class fndts::os::Clock
+{
+    private:
+        /* Only class methods: construction disabled */
+        Clock() {}
+
+    public:
+        /**
+         *  \brief  Gets the current time of the monotonic clock.
+         *  \return The time in nanoseconds.
+        **/
+        static inline tNanos now()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<tNanos>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+        }
+
+        /**
+         *  \brief  Gets the resolution of the monotonic clock.
+         *  \return The resolution in nanoseconds.
+        **/
+        static tNanos getResolution();
+};
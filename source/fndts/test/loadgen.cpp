@@ -0,0 +1,410 @@
+// Foundations library: synthetic load generator -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include "alf/Logger.h"
+#include "alf/LogChannel.h"
+#include "comms/LatencyHistogram.h"
+#include "comms/Message.h"
+#include "comms/Queue.h"
+#include "comms/SysQueue.h"
+#include "os/thread/FutexThread.h"
+#include "os/thread/Thread.h"
+#include "os/time/Clock.h"
+
+using namespace fndts;
+using os::tNanos;
+using os::Clock;
+
+/* Waits shorter than this are spun instead of slept */
+#define LOADGEN_SPIN    50000ULL
+
+/* A step is saturated when it achieves less than this share of the offer */
+#define LOADGEN_ACHIEVED    0.95
+
+/* ... or when its p99 grows this many times over the first step's one */
+#define LOADGEN_P99GROWTH   10
+
+/* The settings of a run */
+struct tLoad
+{
+    unsigned int producers;     /* Sending threads */
+    unsigned int consumers;     /* Receiving threads */
+    double rate;                /* Offered msg/s of all producers together */
+    double burst;               /* Mean messages per arrival */
+    double duration;            /* Seconds each producer sends */
+    double lograte;             /* Logs/s of each producer */
+    std::vector<size_t> sizes;  /* Payload sizes of the mix */
+    std::vector<double> weights;    /* Share of each size, adding up to 1 */
+};
+
+/* Counters shared by the consumers of a step */
+struct tResult
+{
+    comms::LatencyHistogram latency;    /* Scheduled send to receive */
+    volatile unsigned long received;    /* Messages received */
+    volatile tNanos last;               /* Time of the last receive */
+};
+
+/* Uniform random number in (0, 1] */
+static double uniform(unsigned int & seed)
+{
+    return (rand_r(&seed) + 1.0) / (RAND_MAX + 1.0);
+}
+
+/* Sleeps most of the wait and spins the rest */
+static void waitUntil(const tNanos t)
+{
+    tNanos now = Clock::now();
+    if (now >= t) return;
+    if (t - now > LOADGEN_SPIN)
+    {
+        tNanos d = t - now - LOADGEN_SPIN / 2;
+        struct timespec ts;
+        ts.tv_sec = d / 1000000000ULL;
+        ts.tv_nsec = d % 1000000000ULL;
+        nanosleep(&ts, NULL);
+    }
+    while (Clock::now() < t)
+        os::FutexThread::relax();
+}
+
+/* Sends bursts of messages with exponential gaps between them */
+class Producer : public os::Thread
+{
+    private:
+        comms::Channel & channel;
+        const tLoad & load;
+        double rate;
+        unsigned int seed;
+        alf::LogChannel *logchannel;
+        unsigned long sent;
+        volatile bool done;
+
+        /* Picks a payload size from the mix */
+        size_t pickSize()
+        {
+            double u = uniform(seed);
+            for (size_t i=0; i+1<load.sizes.size(); i++)
+            {
+                if (u <= load.weights[i]) return load.sizes[i];
+                u -= load.weights[i];
+            }
+            return load.sizes.back();
+        }
+
+    protected:
+        /* The payload starts with the time the message was due, not the
+           time it was sent, so that a late producer does not hide the
+           queueing delay it suffered */
+        virtual void * threadStartRoutine(void *arg)
+        {
+            size_t mx = 0;
+            for (size_t i=0; i<load.sizes.size(); i++)
+                if (load.sizes[i] > mx) mx = load.sizes[i];
+            std::vector<comms::tByte> payload(mx, 0x5a);
+
+            tNanos start = Clock::now();
+            tNanos end = start + (tNanos)(load.duration * 1e9);
+            tNanos due = start;
+            tNanos nextlog = start;
+            double gap = 1e9 * load.burst / rate;
+            while (due < end)
+            {
+                waitUntil(due);
+
+                /* Geometric burst size with the given mean */
+                unsigned int k = 1;
+                while (uniform(seed) > 1.0 / load.burst) k++;
+                for (unsigned int i=0; i<k; i++)
+                {
+                    memcpy(&payload[0], &due, sizeof(due));
+                    comms::Message m(pickSize(), &payload[0]);
+                    if (channel.send(m)) sent++;
+                }
+
+                if (logchannel != NULL && Clock::now() >= nextlog)
+                {
+                    std::ostringstream s;
+                    s << getName() << ": " << sent << " messages sent";
+                    logchannel->log(s.str());
+                    nextlog += (tNanos)(1e9 / load.lograte);
+                }
+                due += (tNanos)(-log(uniform(seed)) * gap) + 1;
+            }
+            done = true;
+            return NULL;
+        }
+
+    public:
+        Producer(const std::string & n, comms::Channel & c, const tLoad & l,
+                 const unsigned int s, alf::LogChannel *lc)
+        :Thread(n),channel(c),load(l),rate(l.rate / l.producers),seed(s),
+         logchannel(lc),sent(0),done(false) {}
+        bool isDone() const { return done; }
+        unsigned long getSent() const { return sent; }
+};
+
+/* Receives until it gets a message too short for a timestamp, recording
+   latencies */
+class Consumer : public os::Thread
+{
+    private:
+        comms::Channel & channel;
+        tResult & result;
+
+    protected:
+        virtual void * threadStartRoutine(void *arg)
+        {
+            comms::Message m;
+            while (channel.receive(m) && m.size() >= sizeof(tNanos))
+            {
+                tNanos due;
+                memcpy(&due, m.getData(), sizeof(due));
+                tNanos now = Clock::now();
+                result.latency.record(now > due ? now - due : 0);
+                __sync_add_and_fetch(&result.received, 1);
+                result.last = now;
+            }
+            return NULL;
+        }
+
+    public:
+        Consumer(const std::string & n, comms::Channel & c, tResult & r)
+        :Thread(n),channel(c),result(r) {}
+};
+
+/* Gets the number of messages waiting in the channel */
+static size_t depth(comms::Queue *q, comms::SysQueue *sq)
+{
+    if (q != NULL) return q->size();
+    struct msqid_ds ds;
+    if (sq != NULL && msgctl(sq->getSystemID(), IPC_STAT, &ds) == 0)
+        return ds.msg_qnum;
+    return 0;
+}
+
+/* Gets a percentile, bounded by the highest latency seen */
+static double percentile(const comms::LatencyHistogram & h, const double p)
+{
+    tNanos v = h.getPercentile(p);
+    return (v < h.getMax() ? v : h.getMax()) / 1e3;
+}
+
+/* Parses a size mix such as "64:70,512:25,8192:5" */
+static bool parseSizes(const char *s, tLoad & load)
+{
+    load.sizes.clear();
+    load.weights.clear();
+    double total = 0;
+    while (*s != '\0')
+    {
+        char *e;
+        unsigned long sz = strtoul(s, &e, 10);
+        double w = 1;
+        if (*e == ':') w = strtod(e + 1, &e);
+        if (e == s || w <= 0 || (*e != ',' && *e != '\0')) return false;
+        if (sz < sizeof(tNanos)) sz = sizeof(tNanos);
+        load.sizes.push_back(sz);
+        load.weights.push_back(w);
+        total += w;
+        s = (*e == ',') ? e + 1 : e;
+    }
+    for (size_t i=0; i<load.weights.size(); i++) load.weights[i] /= total;
+    return !load.sizes.empty();
+}
+
+/* Prints the usage of the program */
+void usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " [-producers <n>] [-consumers <n>]"
+              << " [-rate <msg/s>] [-burst <mean>] [-sizes <size:weight,...>]"
+              << " [-duration <s>] [-log <logs/s>] [-sweep <steps> <factor>]"
+              << " [-sysqueue <key file> <project id>]" << std::endl
+              << "  Offers bursty traffic to a Queue (or a SysQueue) and"
+              << " prints the latency and" << std::endl
+              << "  queue depth for each offered rate. Logs go to the"
+              << " standard error." << std::endl;
+}
+
+/* Runs the offered rates and reports the queueing curve */
+int main(int argc, char *argv[])
+{
+    tLoad load;
+    load.producers = 2;
+    load.consumers = 1;
+    load.rate = 10000;
+    load.burst = 1;
+    load.duration = 1;
+    load.lograte = 0;
+    parseSizes("64", load);
+    unsigned int steps = 1;
+    double factor = 2;
+    const char *keyfile = NULL;
+    char project = 'A';
+
+    for (int i=1; i<argc; i++)
+    {
+        bool ok = true;
+        if (strcmp(argv[i], "-producers") == 0 && i+1 < argc)
+            ok = (load.producers = atoi(argv[++i])) > 0;
+        else if (strcmp(argv[i], "-consumers") == 0 && i+1 < argc)
+            ok = (load.consumers = atoi(argv[++i])) > 0;
+        else if (strcmp(argv[i], "-rate") == 0 && i+1 < argc)
+            ok = (load.rate = atof(argv[++i])) > 0;
+        else if (strcmp(argv[i], "-burst") == 0 && i+1 < argc)
+            ok = (load.burst = atof(argv[++i])) >= 1;
+        else if (strcmp(argv[i], "-sizes") == 0 && i+1 < argc)
+            ok = parseSizes(argv[++i], load);
+        else if (strcmp(argv[i], "-duration") == 0 && i+1 < argc)
+            ok = (load.duration = atof(argv[++i])) > 0;
+        else if (strcmp(argv[i], "-log") == 0 && i+1 < argc)
+            ok = (load.lograte = atof(argv[++i])) >= 0;
+        else if (strcmp(argv[i], "-sweep") == 0 && i+2 < argc)
+        {
+            ok = (steps = atoi(argv[++i])) > 0;
+            ok = (factor = atof(argv[++i])) > 1 && ok;
+        }
+        else if (strcmp(argv[i], "-sysqueue") == 0 && i+2 < argc)
+        {
+            keyfile = argv[++i];
+            project = argv[++i][0];
+        }
+        else ok = false;
+
+        if (!ok)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    comms::Queue *q = NULL;
+    comms::SysQueue *sq = NULL;
+    if (keyfile != NULL) sq = new comms::SysQueue(keyfile, project);
+    else q = new comms::Queue();
+    comms::Channel & channel = (q != NULL) ? (comms::Channel &)*q : *sq;
+
+    alf::LogChannel *lc = NULL;
+    if (load.lograte > 0)
+        lc = &alf::Logger::getLogger().openLogChannel("loadgen");
+
+    std::cout << std::setw(12) << "offered" << std::setw(12) << "achieved"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+              << std::setw(12) << "p99.9 us" << std::setw(12) << "max us"
+              << std::setw(10) << "avg depth" << std::setw(10) << "max depth"
+              << std::endl;
+
+    double offered = load.rate;
+    tNanos basep99 = 0;
+    double saturation = 0;
+    unsigned int saturated = 0;
+    for (unsigned int step=0; step<steps && saturated<2; step++)
+    {
+        tResult result;
+        result.received = 0;
+        result.last = 0;
+        load.rate = offered;
+
+        std::vector<Consumer *> consumers;
+        std::vector<Producer *> producers;
+        for (unsigned int i=0; i<load.consumers; i++)
+        {
+            std::ostringstream n;
+            n << "consumer " << step << "." << i;
+            consumers.push_back(new Consumer(n.str(), channel, result));
+            consumers.back()->launch(NULL);
+        }
+        tNanos start = Clock::now();
+        for (unsigned int i=0; i<load.producers; i++)
+        {
+            std::ostringstream n;
+            n << "producer " << step << "." << i;
+            producers.push_back(new Producer(n.str(), channel, load,
+                                             step * 7919 + i + 1, lc));
+            producers.back()->launch(NULL);
+        }
+
+        /* Sample the depth of the channel while the producers send */
+        size_t maxdepth = 0;
+        double sumdepth = 0;
+        unsigned long samples = 0;
+        bool sending = true;
+        while (sending)
+        {
+            size_t d = depth(q, sq);
+            if (d > maxdepth) maxdepth = d;
+            sumdepth += d;
+            samples++;
+            waitUntil(Clock::now() + 1000000ULL);
+            sending = false;
+            for (size_t i=0; i<producers.size(); i++)
+                sending = sending || !producers[i]->isDone();
+        }
+
+        unsigned long sent = 0;
+        for (size_t i=0; i<producers.size(); i++)
+        {
+            producers[i]->join();
+            sent += producers[i]->getSent();
+            delete producers[i];
+        }
+        comms::tByte stop = 0;
+        for (size_t i=0; i<consumers.size(); i++)
+            channel.send(comms::Message(1, &stop));
+        for (size_t i=0; i<consumers.size(); i++)
+        {
+            consumers[i]->join();
+            delete consumers[i];
+        }
+
+        /* The achieved rate counts the time needed to drain the backlog */
+        double secs = (result.last > start ? result.last - start : 1) / 1e9;
+        double achieved = result.received / secs;
+        tNanos p99 = result.latency.getPercentile(99);
+        if (step == 0) basep99 = p99 > 1000 ? p99 : 1000;
+        bool sat = achieved < LOADGEN_ACHIEVED * sent / load.duration ||
+                   p99 > LOADGEN_P99GROWTH * basep99;
+        if (sat && saturated++ == 0) saturation = offered;
+
+        std::cout << std::fixed << std::setprecision(0)
+                  << std::setw(12) << sent / load.duration
+                  << std::setw(12) << achieved << std::setprecision(1)
+                  << std::setw(12) << percentile(result.latency, 50)
+                  << std::setw(12) << percentile(result.latency, 99)
+                  << std::setw(12) << percentile(result.latency, 99.9)
+                  << std::setw(12) << result.latency.getMax() / 1e3
+                  << std::setw(10) << (samples > 0 ? sumdepth / samples : 0)
+                  << std::setw(10) << maxdepth << (sat ? "  *" : "")
+                  << std::endl;
+        offered *= factor;
+    }
+
+    if (saturation > 0)
+        std::cout << "saturation near " << std::setprecision(0) << saturation
+                  << " msg/s offered" << std::endl;
+    else
+        std::cout << "no saturation up to " << std::setprecision(0)
+                  << offered / factor << " msg/s offered" << std::endl;
+
+    if (lc != NULL) alf::Logger::close();
+    delete q;
+    delete sq;
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Foundations library: capture replay tool -*- C++ -*-
+
+// Copyright (C) 2009
+// Victor Garcia Santos
+//
+// This file was developed as part of the Dynasties game. This library is
+// intended for personal use only; you cannot redistribute it and/or use it in
+// your own program.
+
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include "comms/Queue.h"
+#include "comms/Replayer.h"
+#include "comms/SysQueue.h"
+#include "os/thread/Thread.h"
+#include "os/time/Clock.h"
+
+using namespace fndts;
+
+/* Drains the queue the capture is replayed to */
+class Drain : public os::Thread
+{
+    private:
+        comms::Queue & queue;
+        unsigned long received;
+        volatile bool done;
+
+    protected:
+        virtual void * threadStartRoutine(void *arg)
+        {
+            comms::Message m;
+            while (!done || queue.size() > 0)
+                if (queue.receive(m, 10000000ULL)) received++;
+            return NULL;
+        }
+
+    public:
+        Drain(comms::Queue & q):Thread("drain"),queue(q),received(0),
+                                done(false) {}
+        void finish() { done = true; }
+        unsigned long getReceived() const { return received; }
+};
+
+/* Prints the usage of the program */
+void usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " <capture file> [-asap] [-speed <x>]"
+              << " [-sysqueue <key file> <project id>]" << std::endl
+              << "  Replays a capture file to a Queue drained by a thread,"
+              << " or to a SysQueue." << std::endl;
+}
+
+/* Replays a capture file to a Queue or a SysQueue and reports the rate */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool paced = true;
+    double speed = 1.0;
+    const char *keyfile = NULL;
+    char project = 'A';
+    for (int i=2; i<argc; i++)
+    {
+        if (strcmp(argv[i], "-asap") == 0)
+            paced = false;
+        else if (strcmp(argv[i], "-speed") == 0 && i+1 < argc)
+            speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "-sysqueue") == 0 && i+2 < argc)
+        {
+            keyfile = argv[++i];
+            project = argv[++i][0];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    comms::Replayer replayer(argv[1]);
+    if (!replayer.isOpen())
+    {
+        std::cerr << argv[1] << ": not a capture file" << std::endl;
+        return 1;
+    }
+
+    os::tNanos start = os::Clock::now();
+    unsigned long sent;
+    unsigned long received;
+    if (keyfile != NULL)
+    {
+        /* Attached by id, so that the queue is not removed when done */
+        comms::SysQueue sq(msgget(ftok(keyfile, project), 0600 | IPC_CREAT));
+        sent = replayer.replay(sq, paced, speed);
+        received = sent;
+    }
+    else
+    {
+        comms::Queue q;
+        Drain drain(q);
+        drain.launch(NULL);
+        sent = replayer.replay(q, paced, speed);
+        drain.finish();
+        drain.join();
+        received = drain.getReceived();
+    }
+    double secs = (os::Clock::now() - start) / 1e9;
+
+    std::cout << "records:  " << replayer.getRecordCount() << std::endl
+              << "sent:     " << sent << std::endl
+              << "received: " << received << std::endl
+              << "seconds:  " << secs << std::endl
+              << "msg/s:    " << (secs > 0 ? sent / secs : 0) << std::endl;
+    return 0;
+}
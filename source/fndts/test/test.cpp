@@ -8,10 +8,41 @@
 // your own program.
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 #include <string>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/msg.h>
 #include "alf/LogChannel.h"
 #include "alf/Logger.h"
+#include "alf/LogRing.h"
+#include "alf/LogFormat.h"
+#include "comms/Queue.h"
+#include "comms/ShardedQueue.h"
+#include "comms/TimerQueue.h"
+#include "comms/ConflatingQueue.h"
+#include "comms/ByteRing.h"
+#include "comms/SeqLock.h"
+#include "comms/RingBuffer.h"
+#include "comms/RingStage.h"
+#include "comms/Message.h"
+#include "comms/Topic.h"
+#include "comms/Filter.h"
+#include "comms/CaptureTap.h"
+#include "comms/Replayer.h"
+#include "comms/SysQueue.h"
+#include "comms/Bridge.h"
+#include "comms/BridgeReceiver.h"
+#include "actor/Actor.h"
+#include "actor/ActorSystem.h"
+#include "flow/Pipeline.h"
+#include "flow/Stage.h"
 #include "os/thread/Thread.h"
+#include "os/time/Clock.h"
 
 using namespace fndts;
 
@@ -49,6 +80,597 @@ void alftest()
     //l1.closeLogChannel(lc1.getName());
 }
 
+/* Reports the result of a check of a component. Returns whether it passed. */
+bool check(const char *test, const char *what, const bool ok)
+{
+    std::cout << test << " test: " << what << (ok ? ": OK" : ": FAILED")
+              << std::endl;
+    return ok;
+}
+
+/* Tests the COMMS Queue: expiry, bounded sends and close. */
+bool queuetest()
+{
+    bool ok = true;
+    comms::Message r;
+
+    /* Expired messages are dropped and counted, not delivered */
+    comms::Queue q;
+    comms::Message old(4,(const comms::tByte *)"old");
+    comms::Message fresh(6,(const comms::tByte *)"fresh");
+    old.setDeadline(1);
+    q.send(old);
+    q.send(fresh);
+    ok &= check("Queue","expired message dropped",
+                q.tryReceive(r) && r.size() == 6 && q.getExpiredCount() == 1);
+    ok &= check("Queue","queue empty after expiry", !q.tryReceive(r));
+
+    /* sweep discards expired messages anywhere in the queue */
+    q.send(fresh);
+    q.send(old);
+    q.send(fresh);
+    ok &= check("Queue","sweep drops expired messages behind the front",
+                q.sweep() == 1 && q.size() == 2 && q.getExpiredCount() == 2
+                && q.tryReceive(r) && q.tryReceive(r) && !q.tryReceive(r));
+
+    /* trySend fails on a full bounded queue */
+    comms::Queue b(2);
+    ok &= check("Queue","trySend below capacity",
+                b.trySend(fresh) && b.trySend(fresh));
+    ok &= check("Queue","trySend on a full queue",
+                !b.trySend(fresh) && b.size() == 2);
+
+    /* close discards the messages and gives their places back */
+    b.close();
+    ok &= check("Queue","close empties the queue",
+                b.size() == 0 && !b.tryReceive(r));
+    ok &= check("Queue","trySend after close",
+                b.trySend(fresh) && b.trySend(old) && !b.trySend(old));
+    ok &= check("Queue","receive after close",
+                b.tryReceive(r) && r.size() == 6);
+    return ok;
+}
+
+/* Tests the COMMS ShardedQueue: FIFO within a shard, stealing from the
+ * others, and close. */
+bool shardedtest()
+{
+    bool ok = true;
+    comms::ShardedQueue q(4);
+    comms::Message m, r;
+    for (unsigned int i=0; i<16; i++)
+    {
+        m.setType(i);
+        q.send(m, i);
+    }
+    ok &= check("ShardedQueue","messages spread in the shards",
+                q.getShardCount() == 4 && q.size() == 16);
+    bool fifo = true;
+    int last[4] = { -1, -1, -1, -1 };
+    unsigned int n = 0;
+    while (q.tryReceive(r))
+    {
+        fifo &= (int)r.getType() > last[r.getType() % 4];
+        last[r.getType() % 4] = r.getType();
+        n++;
+    }
+    ok &= check("ShardedQueue","FIFO order within each shard",
+                fifo && n == 16 && q.getStealCount() >= 12);
+    q.close();
+    ok &= check("ShardedQueue","send after close", !q.send(m));
+    return ok;
+}
+
+/* Tests the COMMS TimerQueue: delivery in time order, after the delay, and
+ * cancellation. */
+bool timertest()
+{
+    bool ok = true;
+    comms::Queue out;
+    comms::TimerQueue tq(out);
+    comms::Message a, b, c, r;
+    a.setType(1);
+    b.setType(2);
+    c.setType(3);
+    os::tNanos start = os::Clock::now();
+    tq.schedule(a, 30);
+    tq.schedule(b, 10);
+    comms::tTimerId id = tq.schedule(c, 20);
+    ok &= check("TimerQueue","cancel a pending message",
+                tq.cancel(id) && tq.size() == 2);
+    bool first = out.receive(r, 1000000000ULL) && r.getType() == 2
+                 && os::Clock::now() - start >= 10000000ULL;
+    bool second = out.receive(r, 1000000000ULL) && r.getType() == 1
+                  && os::Clock::now() - start >= 30000000ULL;
+    ok &= check("TimerQueue","messages delivered in time order",
+                first && second && tq.size() == 0);
+    ok &= check("TimerQueue","cancelled message not delivered",
+                !out.receive(r, 50000000ULL) && !tq.cancel(id));
+    tq.close();
+    ok &= check("TimerQueue","schedule after close", tq.schedule(a, 1) == 0);
+    return ok;
+}
+
+/* Tests the COMMS ConflatingQueue: the newest message of a key replaces the
+ * pending one in place, and close. */
+bool conflatingtest()
+{
+    bool ok = true;
+    comms::ConflatingQueue q;
+    comms::Message old(1,(const comms::tByte *)"o");
+    comms::Message other(2,(const comms::tByte *)"ot");
+    comms::Message fresh(3,(const comms::tByte *)"new");
+    comms::Message r;
+    old.setType(1);
+    other.setType(2);
+    fresh.setType(1);
+    q.send(old);
+    q.send(other);
+    q.send(fresh);
+    ok &= check("ConflatingQueue","newest message kept for a key",
+                q.size() == 2 && q.getConflatedCount() == 1);
+    ok &= check("ConflatingQueue","replaced message keeps its place",
+                q.receive(r) && r.getType() == 1 && r.size() == 3
+                && q.receive(r) && r.getType() == 2);
+    q.send(old);
+    q.close();
+    q.send(other);
+    ok &= check("ConflatingQueue","receive after close",
+                q.receive(r) && r.getType() == 2 && q.size() == 0);
+    return ok;
+}
+
+/* Tests the COMMS ByteRing: records read in place across the wrap of the
+ * ring, a full ring, and the message header through send and receive. */
+bool byteringtest()
+{
+    bool ok = true;
+    comms::ByteRing ring(4096);
+    bool inplace = true;
+    for (unsigned int i=0; i<20; i++)
+    {
+        comms::tByte *w = ring.reserve(1000);
+        if (w == NULL) { inplace = false; break; }
+        memset(w, i, 1000);
+        ring.commit();
+        size_t len = 0;
+        const comms::tByte *p = ring.peek(len);
+        inplace &= p != NULL && len == 1000 && p[0] == i && p[999] == i;
+        ring.release();
+    }
+    ok &= check("ByteRing","records read in place across the wrap",
+                inplace && ring.used() == 0);
+
+    std::vector<comms::tByte> zeros(1000);
+    comms::Message m(zeros.size(), &zeros[0]), r;
+    m.setType(9);
+    unsigned int sent = 0;
+    while (ring.send(m)) sent++;
+    unsigned int got = 0;
+    bool typed = true;
+    while (ring.used() > 0 && ring.receive(r))
+    {
+        typed &= r.getType() == 9 && r.size() == 1000;
+        got++;
+    }
+    ok &= check("ByteRing","send fails on a full ring",
+                sent > 0 && sent < 5 && got == sent && typed);
+    return ok;
+}
+
+/* A snapshot whose fields are always published equal */
+struct tSnapshot
+{
+    unsigned long a, b, c, d;
+};
+
+/* A thread publishing snapshots to a SeqLock */
+class PublishThread : public os::Thread
+{
+    private:
+    comms::SeqLock<tSnapshot> & lock;
+
+    protected:
+    void * threadStartRoutine(void *arg)
+    {
+        for (unsigned long i=1; i<=200000; i++)
+        {
+            tSnapshot v = { i, i, i, i };
+            lock.publish(v);
+        }
+        return NULL;
+    }
+
+    public:
+    PublishThread(const char *n, comms::SeqLock<tSnapshot> & l)
+    : Thread(n), lock(l) {}
+};
+
+/* Tests the COMMS SeqLock: readers never see a torn snapshot, nor an older
+ * one than the previous read. */
+bool seqlocktest()
+{
+    comms::SeqLock<tSnapshot> lock;
+    PublishThread writer("seqlock writer", lock);
+    writer.launch(NULL);
+    bool consistent = true;
+    unsigned long last = 0;
+    tSnapshot v;
+    do
+    {
+        lock.read(v);
+        consistent &= v.a == v.b && v.b == v.c && v.c == v.d && v.a >= last;
+        last = v.a;
+    }
+    while (last < 200000 && consistent);
+    writer.join();
+    return check("SeqLock","snapshots read whole and in order",
+                 consistent && lock.read(v) == 200000 && v.d == 200000);
+}
+
+/* An entry of the ring test: each stage writes its own field */
+struct tRingEntry
+{
+    long long value, a, b, c;
+    bool ok;
+};
+
+/* A stage of the A -> (B, C) -> D ring test, doing the job of its name */
+class DiamondStage : public comms::RingStage<tRingEntry>
+{
+    private:
+    char role;
+    comms::tSequence expected;
+
+    protected:
+    void onEntry(tRingEntry & e, const comms::tSequence s, const bool last)
+    {
+        switch (role)
+        {
+            case 'A': e.a = e.value + 1; break;
+            case 'B': e.b = 2 * e.a; break;
+            case 'C': e.c = 3 * e.a; break;
+            default:
+                e.ok = e.value == s && e.b + e.c == 5 * (s + 1);
+                if (!e.ok || s != expected) failed++;
+                expected = s + 1;
+        }
+    }
+
+    public:
+    unsigned long failed;
+
+    DiamondStage(const char *n, const char j,
+                 comms::RingBuffer<tRingEntry> & r, comms::SequenceBarrier & b)
+    : RingStage<tRingEntry>(n, r, b), role(j), expected(0), failed(0) {}
+};
+
+/* Tests the COMMS RingBuffer and SequenceBarrier: stages of a diamond see
+ * the entries in order, after the stages they depend on. */
+bool ringtest()
+{
+    comms::RingBuffer<tRingEntry> ring(64);
+    DiamondStage a("ring A", 'A', ring, ring.newBarrier());
+    DiamondStage b("ring B", 'B', ring, ring.newBarrier(a.getSequence()));
+    DiamondStage c("ring C", 'C', ring, ring.newBarrier(a.getSequence()));
+    std::vector<const comms::Sequence *> bc;
+    bc.push_back(&b.getSequence());
+    bc.push_back(&c.getSequence());
+    DiamondStage d("ring D", 'D', ring, ring.newBarrier(bc));
+    ring.addGatingSequence(d.getSequence());
+    a.launch(NULL);
+    b.launch(NULL);
+    c.launch(NULL);
+    d.launch(NULL);
+    const comms::tSequence n = 10000;
+    for (comms::tSequence i=0; i<n; i++)
+    {
+        comms::tSequence s = ring.next();
+        ring.get(s).value = s;
+        ring.publish(s);
+    }
+    while (d.getSequence().get() < n - 1) sched_yield();
+    a.halt();
+    b.halt();
+    c.halt();
+    d.halt();
+    a.join();
+    b.join();
+    c.join();
+    d.join();
+    return check("RingBuffer","entries passed through a diamond in order",
+                 d.failed == 0 && d.getSequence().get() == n - 1);
+}
+
+/* Tests the COMMS Topic: filters and unsubscription. */
+bool topictest()
+{
+    bool ok = true;
+    comms::Topic t;
+    comms::Queue all, ones;
+    comms::Message m1, m2, r;
+    m1.setType(1);
+    m2.setType(2);
+    t.subscribe(all);
+    unsigned int id = t.subscribe(ones, comms::Filter::type(1));
+    t.send(m1);
+    t.send(m2);
+    ok &= check("Topic","type filter",
+                ones.size() == 1 && all.size() == 2
+                && t.getDeliveredCount() == 3 && t.getFilteredCount() == 1);
+    ok &= check("Topic","unsubscribe", t.unsubscribe(id) && t.send(m1)
+                && ones.size() == 1 && all.size() == 3);
+    return ok;
+}
+
+/* Tests the COMMS CaptureTap and Replayer: a round trip through a file. */
+bool capturetest()
+{
+    bool ok = true;
+    comms::Queue q, out;
+    comms::Message m, r;
+    {
+        comms::CaptureTap tap(q, "capturetest.cap", true);
+        m.setType(7);
+        tap.send(m);
+        m.setType(8);
+        tap.send(m);
+        tap.receive(r);
+    }
+    comms::Replayer sent("capturetest.cap");
+    ok &= check("CaptureTap","sent messages replayed once",
+                sent.replay(out, false) == 2 && sent.getRecordCount() == 3
+                && out.tryReceive(r) && r.getType() == 7
+                && out.tryReceive(r) && r.getType() == 8);
+    comms::Replayer all("capturetest.cap");
+    ok &= check("CaptureTap","received messages replayed on demand",
+                all.replay(out, false, 1.0, true) == 3);
+    remove("capturetest.cap");
+    return ok;
+}
+
+/* A thread sending a message to a system queue */
+class SendThread : public os::Thread
+{
+    private:
+    comms::SysQueue & queue;
+    const comms::Message & message;
+
+    protected:
+    void * threadStartRoutine(void *arg)
+    {
+        queue.send(message);
+        return NULL;
+    }
+
+    public:
+    SendThread(const char *n, comms::SysQueue & q, const comms::Message & m)
+    : Thread(n), queue(q), message(m) {}
+};
+
+/* Tests the COMMS SysQueue: a message bigger than a system message is
+ * split in fragments and put together again; a short one is counted. */
+bool sysqueuetest()
+{
+    bool ok = true;
+    comms::SysQueue sq(".", 'F');
+    size_t sz = 3 * comms::SysQueue::getMaxPayloadSize() + 100;
+    std::vector<comms::tByte> bytes(sz);
+    for (size_t i=0; i<sz; i++) bytes[i] = (comms::tByte)(i % 251);
+    comms::Message big(sz, &bytes[0]);
+    big.setType(5);
+    SendThread sender("fragment sender", sq, big);
+    sender.launch(NULL);
+    comms::ReceiveBuffer b;
+    bool got = sq.receive(b, 5);
+    sender.join();
+    ok &= check("SysQueue","fragmented message put together",
+                got && b.size() == sz && b.getType() == 5
+                && memcmp(b.data(), &bytes[0], sz) == 0
+                && sq.getPendingCount() == 0);
+
+    struct { long type; char text[1]; } runt = { 5, { 'x' } };
+    msgsnd(sq.getSystemID(), &runt, sizeof(runt.text), 0);
+    ok &= check("SysQueue","message shorter than the header counted",
+                !sq.tryReceive(b, 5) && sq.getMalformedCount() == 1);
+    sq.close();
+    return ok;
+}
+
+/* Tests the COMMS Bridge and BridgeReceiver: a round trip through a system
+ * queue, in batches and in order. */
+bool bridgetest()
+{
+    bool ok = true;
+    comms::SysQueue sq(".", 'T');
+    comms::Queue in, out;
+    comms::Bridge bridge("bridge", in, sq);
+    comms::BridgeReceiver receiver("bridge receiver", sq, out);
+    comms::Message m, r;
+    for (unsigned int i=0; i<1000; i++)
+    {
+        m.setType(i);
+        in.send(m);
+    }
+    bridge.launch(NULL);
+    receiver.launch(NULL);
+    bridge.stop();
+    bridge.join();
+    receiver.stop();
+    receiver.join();
+    bool ordered = true;
+    for (unsigned int i=0; i<1000; i++)
+        ordered &= out.tryReceive(r) && r.getType() == i;
+    ok &= check("Bridge","messages received in order",
+                ordered && out.size() == 0
+                && receiver.getMessageCount() == 1000);
+    ok &= check("Bridge","messages batched in frames",
+                bridge.getFrameCount() < 1000
+                && receiver.getFrameCount() == bridge.getFrameCount());
+    sq.close();
+    return ok;
+}
+
+/* An actor checking that its messages come in order, one at a time */
+class CountActor : public actor::Actor
+{
+    private:
+    volatile int inside;
+    unsigned int expected;
+
+    void onCount(const comms::Message & m)
+    {
+        if (__sync_fetch_and_add(&inside, 1) != 0) failed++;
+        unsigned int n;
+        memcpy(&n, m.getData(), sizeof(n));
+        if (n != expected) failed++;
+        expected = n + 1;
+        __sync_fetch_and_sub(&inside, 1);
+    }
+
+    protected:
+    void unhandled(const comms::Message & m)
+    {
+        memcpy(&expected, m.getData(), sizeof(expected));
+        expected++;
+        others++;
+    }
+
+    public:
+    unsigned long failed, others;
+
+    CountActor(actor::ActorSystem & s)
+    : Actor(s, "counter"), inside(0), expected(0), failed(0), others(0)
+    { handle(1, &CountActor::onCount); }
+};
+
+/* Tests the ACTOR system: the messages of each actor are handled in order
+ * and never by two workers at once; unhandled types go to unhandled(). */
+bool actortest()
+{
+    actor::ActorSystem system("actor", 4, 8);
+    std::vector<CountActor *> actors;
+    for (unsigned int i=0; i<8; i++)
+        actors.push_back(new CountActor(system));
+    for (unsigned int n=0; n<1000; n++)
+        for (size_t i=0; i<actors.size(); i++)
+        {
+            comms::Message m(sizeof(n), (const comms::tByte *)&n);
+            m.setType(n % 100 == 99 ? 2 : 1);
+            actors[i]->send(m);
+        }
+    system.stop();
+    bool handled = true;
+    for (size_t i=0; i<actors.size(); i++)
+    {
+        handled &= actors[i]->failed == 0 && actors[i]->others == 10
+                   && actors[i]->getHandledCount() == 1000;
+        delete actors[i];
+    }
+    return check("Actor","messages handled in order, one at a time",
+                 handled && system.getProcessedCount() == 8000);
+}
+
+/* A stage passing the messages through, slow on some and dropping others */
+class SlowStage : public flow::Stage
+{
+    protected:
+    const bool process(const comms::Message & in, comms::Message & out)
+    {
+        if (in.getType() % 7 == 0) usleep(200);
+        out = in;
+        return in.getType() % 10 != 9;
+    }
+
+    public:
+    SlowStage() : Stage("slow", 4, true, 8) {}
+};
+
+/* Tests the FLOW Pipeline: outputs of several replicas keep the input order. */
+bool pipelinetest()
+{
+    SlowStage s;
+    flow::Pipeline p("pipeline", 16);
+    p.add(s);
+    p.start();
+    comms::Message m, r;
+    for (unsigned int i=0; i<2000; i++)
+    {
+        m.setType(i);
+        p.send(m);
+    }
+    p.stop();
+    bool ordered = true;
+    unsigned int n = 0, next = 0;
+    while (p.receive(r, 1000000))
+    {
+        if (next % 10 == 9) next++;
+        ordered &= (r.getType() == next);
+        next++;
+        n++;
+    }
+    return check("Pipeline","outputs in the input order",
+                 ordered && n == 1800 && s.getDroppedCount() == 200);
+}
+
+/* Tests the ALF LogFormat: arguments written by tLogArg are decoded in the
+ * place of each {}, the ones left appended, and a truncated one ends it. */
+bool logformattest()
+{
+    bool ok = true;
+    static const alf::LogFormat moved("unit {} moved to ({},{})");
+    comms::tByte buffer[128];
+    comms::tByte *e = buffer;
+    e = alf::tLogArg<int>::write(e, -3);
+    e = alf::tLogArg<unsigned int>::write(e, 7u);
+    e = alf::tLogArg<double>::write(e, 2.5);
+    e = alf::tLogArg<const char *>::write(e, "far");
+    e = alf::tLogArg<bool>::write(e, true);
+    ok &= check("LogFormat","format registered",
+                alf::LogFormat::find(moved.getId()) == &moved);
+    ok &= check("LogFormat","arguments decoded",
+                moved.toText(buffer, e)
+                == "unit -3 moved to (7,2.5) far true");
+    ok &= check("LogFormat","truncated argument ends the text",
+                moved.toText(buffer, e - 1) == "unit -3 moved to (7,2.5) far ");
+    return ok;
+}
+
+/* Tests the ALF LogStream: lines split at new lines and stream state kept
+ * along the statement. The Logger is closed to get the lines written. */
+bool logstreamtest()
+{
+    bool ok = true;
+    std::ostringstream out;
+    std::streambuf *old = std::clog.rdbuf(out.rdbuf());
+    alf::LogChannel & lc = alf::Logger::getLogger().openLogChannel("stream");
+    lc << "first " << 1 << "\nsecond " << std::hex << 255 << " "
+       << std::setw(4) << 7 << " " << std::setprecision(3) << 3.14159
+       << "\n";
+    lc << "third " << 255;
+    alf::Logger::getLogger().close();
+    std::clog.rdbuf(old);
+    std::clog << out.str();
+    const std::string t = out.str();
+    ok &= check("LogStream","lines split at new lines",
+                t.find(": first 1\n") != std::string::npos
+                && t.find(": third 255\n") != std::string::npos);
+    ok &= check("LogStream","manipulators kept along the statement",
+                t.find(": second ff    7 3.14\n") != std::string::npos);
+    return ok;
+}
+
+/* Tests the ALF LogRing without Logger: logs are dropped, not waited for. */
+bool logringtest()
+{
+    unsigned long before = alf::LogRing::getDroppedCount();
+    bool sent = true;
+    for (int i=0; i<10000; i++)
+        sent &= alf::LogRing::send(alf::eSTANDARD,0,"canal1","No Logger");
+    return check("LogRing","logs dropped without Logger",
+                 !sent && alf::LogRing::getDroppedCount() > before);
+}
+
 /* My thread class to test ALf with concurrent accesses */
 class OneThread : public os::Thread
 {
@@ -68,6 +690,20 @@ class OneThread : public os::Thread
 /* Main function */
 int main()
 {
+    bool ok = queuetest();
+    ok &= shardedtest();
+    ok &= timertest();
+    ok &= conflatingtest();
+    ok &= byteringtest();
+    ok &= seqlocktest();
+    ok &= ringtest();
+    ok &= topictest();
+    ok &= capturetest();
+    ok &= sysqueuetest();
+    ok &= bridgetest();
+    ok &= actortest();
+    ok &= pipelinetest();
+
     OneThread t1("thread 1");
     OneThread t2("thread 2");
     OneThread t3("thread 3");
@@ -98,6 +734,10 @@ int main()
     t8.join();
     t9.join();
     ta.join();
-    alf::Logger::getLogger().close();
-    return 0;
+    ok &= check("LogRing","no log dropped while the Logger runs",
+                alf::LogRing::getDroppedCount() == 0);
+    ok &= logformattest();
+    ok &= logstreamtest();
+    ok &= logringtest();
+    return ok ? 0 : 1;
 }